@@ -0,0 +1,82 @@
+#include <chrono>
+#include "async_solve.h"
+
+namespace {
+
+/*!
+  \brief Lends a control to a solver until it goes out of scope, also when
+         the search throws
+*/
+class ControlLoan {
+
+  public:
+    ControlLoan(CspSolver &solver, SearchControl &control) : solver(solver) {
+      solver.set_search_control(&control);
+    }
+    ~ControlLoan() { solver.set_search_control(nullptr); }
+    ControlLoan(const ControlLoan &) = delete;
+    ControlLoan &operator=(const ControlLoan &) = delete;
+
+  private:
+    CspSolver &solver;
+};
+
+}
+
+/*!
+  \brief Starts the search
+
+  \param solver A solver with all clues given, not to be used until the
+                search is done
+  \param seconds Time limit, 0 for none
+  \param max_nodes Limit on the nodes of the combo search, 0 for none
+  \param max_combos Stop after this many combos, 0 finds all
+*/
+AsyncSolve::AsyncSolve(CspSolver &solver, double seconds, uint64_t max_nodes,
+                       std::size_t max_combos)
+  : solver(solver), max_combos(max_combos) {
+  control.set_time_limit(seconds);
+  control.set_node_limit(max_nodes);
+  done_future = std::async(std::launch::async, [this]() { run(); }).share();
+}
+
+AsyncSolve::~AsyncSolve() {
+  control.cancel();
+  done_future.wait();
+}
+
+/*!
+  \brief Waits until the search is done or the time is up
+
+  \return true if the search is done
+*/
+bool AsyncSolve::wait_for(double seconds) const {
+  return done_future.wait_for(std::chrono::duration<double>(seconds)) ==
+    std::future_status::ready;
+}
+
+// Private methods ----------------------------------------------
+
+void AsyncSolve::run() {
+  try {
+    ControlLoan loan(solver, control);
+    solver.for_each_possibility([this](const Factoid &factoid) {
+        possibility_list.push_back(factoid);
+        return control.poll();
+      });
+    if (control.stopped()) {
+      return;
+    }
+
+    solver.for_each_combo(possibility_list, [this](const FactCombo &combo) {
+        combo_list.push_back(combo);
+        control.add_combo();
+        return (combo_list.size() != max_combos);
+      });
+  }
+  catch (...) {
+    control.fail();
+    throw;
+  }
+  control.finish();
+}
@@ -0,0 +1,61 @@
+#ifndef ASYNC_SOLVE_H
+#define ASYNC_SOLVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include "csp_solver.h"
+#include "search_control.h"
+
+/*!
+  \brief Lists the possibilities and combos of a solver on a thread of its
+         own, within a budget
+
+  The search starts at construction and can be watched, cancelled or waited
+  for from the thread that made it. When the time or node limit is reached
+  or it is cancelled, the search stops at the next node and keeps the combos
+  found so far, status() tells why it ended. A limit on the combos, e.g. 2
+  to check that a puzzle has one solution, ends it as finished.
+
+  The solver must not be used until the search is done. The destructor
+  cancels the search and waits for it. If the search throws, e.g. running
+  out of memory for the lists, status() is SEARCH_FAILED and wait()
+  rethrows the exception.
+*/
+class AsyncSolve {
+
+public:
+
+  AsyncSolve(CspSolver &solver, double seconds = 0, uint64_t max_nodes = 0,
+             std::size_t max_combos = 0);
+  ~AsyncSolve();
+  AsyncSolve(const AsyncSolve &) = delete;
+  AsyncSolve &operator=(const AsyncSolve &) = delete;
+
+  void cancel() { control.cancel(); }
+  bool wait_for(double seconds) const;
+  void wait() const { done_future.get(); }
+  bool done() const { return wait_for(0); }
+
+  SearchStatus status() const { return control.status(); }
+  uint64_t nodes() const { return control.nodes(); }
+  uint64_t combos_found() const { return control.combos(); }
+  double fraction() const { return control.fraction(); }
+
+  // Only to be read once the search is done
+  const PossibilityList &possibilities() const { return possibility_list; }
+  const ComboList &combos() const { return combo_list; }
+
+private:
+
+  CspSolver &solver;
+  std::size_t max_combos;
+  SearchControl control;
+  PossibilityList possibility_list;
+  ComboList combo_list;
+  std::shared_future<void> done_future;
+
+  void run();
+};
+
+#endif
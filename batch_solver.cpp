@@ -0,0 +1,301 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "csp_solver.h"
+#include "puzzle.h"
+#include "puzzle_cache.h"
+#include "puzzle_format.h"
+#include "thread_pool.h"
+
+// Solves the puzzles of a file, see PuzzleReader for the format, e.g.
+//
+//   benchmark --values 6 --properties 6 --puzzles 100 --write puzzles.txt
+//   batch_solver --threads 8 puzzles.txt
+//
+// The solutions are written to stdout in the order the puzzles are solved,
+// a summary goes to stderr. With --cache, puzzles that were solved before,
+// also under other names or in another order, are looked up in a file
+// instead, see SolutionCache. With --time-limit, a puzzle whose solve, from
+// listing its possibilities to the search, takes longer is given up with
+// "timeout NAME".
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Dense tables above this many cells take more memory than they're worth
+const double MAX_DENSE_CELLS = 1 << 26;
+
+/*!
+  \brief A solver and its fact items, reused for all puzzles of one shape
+
+  Each puzzle is solved between push_checkpoint() and rollback(), so the
+  next one starts from the empty table without building it again.
+*/
+class Workspace {
+
+  public:
+    std::unique_ptr<CspSolver> solver;
+    FactItems items;
+};
+
+typedef std::map<std::pair<int, int>, Workspace> Workspaces;
+
+void usage() {
+  std::cerr << "Usage: batch_solver [--threads T] [--no-propagate]"
+            << " [--cache CACHE]" << std::endl
+            << "                    [--time-limit SECONDS] [FILE]"
+            << std::endl;
+  std::exit(1);
+}
+
+Workspace &workspace_for(Workspaces &workspaces, const Puzzle &puzzle) {
+  Workspace &workspace = workspaces[{puzzle.num_values,
+                                     puzzle.num_properties}];
+  if (!workspace.solver) {
+    double cells = 1;
+    for (int property = 0; property < puzzle.num_properties; ++property) {
+      cells *= puzzle.num_values;
+    }
+    workspace.solver.reset(new CspSolver(puzzle.num_values,
+                                         puzzle.num_properties,
+                                         cells > MAX_DENSE_CELLS ?
+                                         PAIRWISE_TABLE : DENSE_TABLE));
+    workspace.items = puzzle.make_items(*workspace.solver);
+  }
+  return workspace;
+}
+
+/*!
+  \brief Solves a puzzle
+
+  \param[in] time_limit Seconds that the whole solve may take, 0 for no
+                        limit
+  \param[out] result Whether it has no, one or several solutions
+  \param[out] rows The solution, one factoid per house, if it is unique
+  \return false if the solve ran out of time
+*/
+bool solve(Workspaces &workspaces, const Puzzle &puzzle, bool propagate,
+           double time_limit, SolveResult &result,
+           std::vector<Factoid> &rows) {
+  Workspace &workspace = workspace_for(workspaces, puzzle);
+  CspSolver &solver = *workspace.solver;
+  SearchControl control;
+  control.set_time_limit(time_limit);
+  solver.set_search_control(&control);
+
+  solver.push_checkpoint();
+  for (const Clue &clue : puzzle.clues) {
+    puzzle.apply(solver, workspace.items, clue);
+  }
+  if (propagate) {
+    solver.propagate();
+  }
+
+  PossibilityList possibilities;
+  Factoid factoid(puzzle.num_properties);
+  solver.get_possibilities(0, factoid, possibilities);
+  FactCombo first;
+  const std::size_t found = control.stopped() ? 0 :
+    solver.for_each_combo(possibilities,
+                          [&first](const FactCombo &combo) {
+                            if (first.empty()) {
+                              first = combo;
+                              return true;
+                            }
+                            return false;
+                          });
+  solver.set_search_control(nullptr);
+  solver.rollback();
+
+  rows.clear();
+  if (control.stopped()) {
+    return false;
+  }
+  if (found == 1) {
+    for (int index : first) {
+      rows.push_back(Factoid(possibilities[index]));
+    }
+  }
+  result = found == 0 ? NO_SOLUTION :
+    found == 1 ? UNIQUE_SOLUTION : MANY_SOLUTIONS;
+  return true;
+}
+
+/*!
+  \brief Formats the answer to a puzzle
+
+  \return "solution NAME" followed by one line per house and "end", or
+          "no_solution NAME" or "ambiguous NAME"
+*/
+std::string answer(const Puzzle &puzzle, SolveResult result,
+                   const std::vector<Factoid> &rows) {
+  const std::string name = puzzle.name.empty() ? "unnamed" : puzzle.name;
+  if (result == NO_SOLUTION) {
+    return "no_solution " + name + "\n";
+  }
+  if (result == MANY_SOLUTIONS) {
+    return "ambiguous " + name + "\n";
+  }
+  // One line per item of the first category, in its order
+  std::vector<std::string> lines(puzzle.num_values);
+  for (const Factoid &house : rows) {
+    std::string &line = lines[house[0]];
+    for (int property = 0; property < puzzle.num_properties; ++property) {
+      line += (property ? " " : "") + puzzle.item_name(property,
+                                                       house[property]);
+    }
+  }
+  std::string text = "solution " + name + "\n";
+  for (const std::string &line : lines) {
+    text += line + "\n";
+  }
+  return text + "end\n";
+}
+
+double since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char* argv[])
+  {
+    int num_threads = std::thread::hardware_concurrency();
+    bool propagate = true;
+    std::string path;
+    std::string cache_path;
+    double time_limit = 0;
+
+    for (int i = 1; i < argc; ++i) {
+      const std::string option = argv[i];
+      if (option == "--no-propagate") {
+        propagate = false;
+      }
+      else if (option == "--threads" && i + 1 < argc) {
+        num_threads = std::atoi(argv[++i]);
+      }
+      else if (option == "--cache" && i + 1 < argc) {
+        cache_path = argv[++i];
+      }
+      else if (option == "--time-limit" && i + 1 < argc) {
+        time_limit = std::atof(argv[++i]);
+      }
+      else if (option.compare(0, 2, "--") != 0 && path.empty()) {
+        path = option;
+      }
+      else {
+        usage();
+      }
+    }
+    if (num_threads < 1) {
+      num_threads = 1;
+    }
+
+    std::ifstream file;
+    if (!path.empty()) {
+      file.open(path);
+      if (!file) {
+        std::cerr << "batch_solver: can't open " << path << std::endl;
+        return 1;
+      }
+    }
+    PuzzleReader reader(path.empty() ? std::cin : file);
+
+    std::unique_ptr<SolutionCache> cache;
+    if (!cache_path.empty()) {
+      cache.reset(new SolutionCache(cache_path));
+      if (!cache->is_open()) {
+        std::cerr << "batch_solver: " << cache->error() << std::endl;
+        return 1;
+      }
+    }
+
+    WorkStealingPool pool(num_threads);
+    std::vector<Workspaces> workspaces(pool.size());
+    std::mutex output_mutex;
+
+    // Reading stays a few puzzles ahead of the workers, so big files
+    // aren't held in memory
+    const int max_in_flight = 4*pool.size();
+    int in_flight = 0;
+    std::mutex flight_mutex;
+    std::condition_variable landed;
+
+    long long num_puzzles = 0;
+    long long solved = 0;
+    long long cache_hits = 0;
+    long long timeouts = 0;
+    Clock::time_point start = Clock::now();
+    Puzzle puzzle(0, 0);
+    while (reader.next(puzzle)) {
+      {
+        std::unique_lock<std::mutex> lock(flight_mutex);
+        landed.wait(lock, [&] { return in_flight < max_in_flight; });
+        ++in_flight;
+      }
+      ++num_puzzles;
+      std::shared_ptr<Puzzle> task_puzzle(new Puzzle(std::move(puzzle)));
+      pool.submit([&, task_puzzle](int worker) {
+        SolveResult result = NO_SOLUTION;
+        std::vector<Factoid> rows;
+        bool hit = false;
+        bool finished = true;
+        if (cache) {
+          const PuzzleKey key(*task_puzzle);
+          hit = cache->find(key, result, rows);
+          if (!hit) {
+            finished = solve(workspaces[worker], *task_puzzle, propagate,
+                             time_limit, result, rows);
+            if (finished) {
+              cache->insert(key, result, rows);
+            }
+          }
+        }
+        else {
+          finished = solve(workspaces[worker], *task_puzzle, propagate,
+                           time_limit, result, rows);
+        }
+        const std::string text = finished ?
+          answer(*task_puzzle, result, rows) :
+          "timeout " + (task_puzzle->name.empty() ? std::string("unnamed") :
+                        task_puzzle->name) + "\n";
+        {
+          std::lock_guard<std::mutex> lock(output_mutex);
+          std::cout << text;
+          solved += (finished && result == UNIQUE_SOLUTION);
+          cache_hits += hit;
+          timeouts += !finished;
+        }
+        {
+          std::lock_guard<std::mutex> lock(flight_mutex);
+          --in_flight;
+        }
+        landed.notify_one();
+      });
+      puzzle = Puzzle(0, 0);
+    }
+    pool.wait();
+    std::cout.flush();
+
+    const double seconds = since(start);
+    if (!reader.error().empty()) {
+      std::cerr << "batch_solver: " << (path.empty() ? "stdin" : path) << ", "
+                << reader.error() << std::endl;
+    }
+    std::cerr << "{\"puzzles\": " << num_puzzles << ", \"solved\": " << solved
+              << ", \"cache_hits\": " << cache_hits
+              << ", \"timeouts\": " << timeouts
+              << ", \"threads\": " << pool.size() << ", \"seconds\": "
+              << seconds << ", \"puzzles_per_sec\": "
+              << (seconds > 0 ? num_puzzles/seconds : 0) << "}" << std::endl;
+
+    return reader.error().empty() && solved == num_puzzles ? 0 : 1;
+  }
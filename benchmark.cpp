@@ -0,0 +1,609 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <sys/resource.h>
+#include "csp_solver.h"
+#include "live_lists.h"
+#include "mapped_truth_table.h"
+#include "puzzle.h"
+#include "puzzle_format.h"
+
+// Times the phases of solving random puzzles with a unique solution and
+// prints the results as JSON, e.g.
+//
+//   benchmark --values 6 --properties 5 --puzzles 20 --engine dlx
+//
+// The puzzles only depend on the seed and size, so runs with different
+// engine options solve the same puzzles. With --check, each puzzle is also
+// solved with every table, engine, propagation and symmetry option, and
+// given to LiveLists one clue at a time, and the run fails unless they all
+// find the same combos.
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+class Phase {
+
+  public:
+    const char *name;
+    const char *unit;
+    double seconds;
+    long long ops;
+};
+
+enum {
+  PHASE_GENERATE = 0,
+  PHASE_SETUP,
+  PHASE_CLUES,
+  PHASE_RELATE,
+  PHASE_FILTER,
+  PHASE_PROPAGATE,
+  PHASE_POSSIBILITIES,
+  PHASE_COMBOS,
+  NUM_PHASES};
+
+// Most combos found without the positional clues, for the filter phase
+const std::size_t FILTER_LIMIT = 100000;
+
+// The same for --check, where each puzzle is solved dozens of times
+const std::size_t CHECK_LIMIT = 1000;
+
+double since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+long peak_rss_kb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss/1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+/*!
+  \brief Makes a solver, with the dimensions compiled in for common shapes
+         if fixed is set, or with the cells in a file if scratch_path isn't
+         empty
+*/
+std::unique_ptr<CspSolver> make_solver(int num_values, int num_properties,
+                                       TableType table_type, bool fixed,
+                                       const std::string &scratch_path) {
+  if (!scratch_path.empty()) {
+    std::unique_ptr<MappedTruthTable> table(
+      new MappedTruthTable(num_values, num_properties, scratch_path));
+    if (!table->is_open()) {
+      std::cerr << "benchmark: " << table->error() << std::endl;
+      return nullptr;
+    }
+    return std::unique_ptr<CspSolver>(new CspSolver(num_values,
+                                                    num_properties,
+                                                    std::move(table)));
+  }
+  if (!fixed) {
+    return std::unique_ptr<CspSolver>(new CspSolver(num_values,
+                                                    num_properties,
+                                                    table_type));
+  }
+  switch (num_values*100 + num_properties) {
+  case 305:
+    return std::unique_ptr<CspSolver>(new FixedCspSolver<3, 5>);
+  case 505:
+    return std::unique_ptr<CspSolver>(new FixedCspSolver<5, 5>);
+  case 506:
+    return std::unique_ptr<CspSolver>(new FixedCspSolver<5, 6>);
+  case 606:
+    return std::unique_ptr<CspSolver>(new FixedCspSolver<6, 6>);
+  }
+  return nullptr;
+}
+
+// The factoids of each combo, sorted, so that solvers that list the
+// possibilities in different orders can be compared
+typedef std::set<std::vector<Factoid>> ComboSet;
+
+/*!
+  \brief One way of solving a puzzle, for --check
+*/
+class Variant {
+
+  public:
+    std::string table;
+    SearchEngine engine;
+    bool propagate;
+    bool symmetry;
+
+    std::string name() const {
+      return table + "/" + (engine == DANCING_LINKS ? "dlx" :
+                            engine == ENUMERATION ? "enum" : "sat") +
+        (propagate ? "/propagate" : "") + (symmetry ? "/symmetry" : "");
+    }
+};
+
+void add_combo(ComboSet &combos, const PossibilityList &possibilities,
+               const FactCombo &combo) {
+  std::vector<Factoid> factoids;
+  for (int index : combo) {
+    factoids.push_back(Factoid(possibilities[index]));
+  }
+  std::sort(factoids.begin(), factoids.end());
+  combos.insert(factoids);
+}
+
+/*!
+  \brief Solves a puzzle one way
+
+  The positional clues are given between push_checkpoint() and rollback(),
+  and the combos of the other clues are listed after the rollback.
+
+  \param[out] combos The combos of all the clues
+  \param[out] loose The combos without the positional clues, at most
+                    CHECK_LIMIT of them
+  \return false if the solver can't be made
+*/
+bool solve_variant(const Puzzle &puzzle, const Variant &variant,
+                   int num_threads, const std::string &scratch_path,
+                   ComboSet &combos, ComboSet &loose) {
+  std::unique_ptr<CspSolver> made =
+    make_solver(puzzle.num_values, puzzle.num_properties,
+                variant.table == "pairwise" ? PAIRWISE_TABLE : DENSE_TABLE,
+                variant.table == "fixed",
+                variant.table == "mapped" ? scratch_path : "");
+  if (!made) {
+    return false;
+  }
+  CspSolver &solver = *made;
+  solver.set_search_engine(variant.engine);
+  solver.set_num_threads(num_threads);
+  solver.set_symmetry_breaking(variant.symmetry);
+  FactItems items = puzzle.make_items(solver);
+  for (const Clue &clue : puzzle.clues) {
+    if (clue.type != RELATE) {
+      puzzle.apply(solver, items, clue);
+    }
+  }
+
+  solver.push_checkpoint();
+  for (const Clue &clue : puzzle.clues) {
+    if (clue.type == RELATE) {
+      puzzle.apply(solver, items, clue);
+    }
+  }
+  if (variant.propagate) {
+    solver.propagate();
+  }
+  PossibilityList possibilities;
+  Factoid factoid(puzzle.num_properties);
+  solver.get_possibilities(0, factoid, possibilities);
+  ComboList combo_list;
+  solver.get_unique_combos(combo_list, possibilities);
+  for (ComboView combo : combo_list) {
+    add_combo(combos, possibilities, FactCombo(combo));
+  }
+  solver.rollback();
+
+  possibilities.clear();
+  solver.get_possibilities(0, factoid, possibilities);
+  solver.for_each_combo(possibilities,
+                        [&loose, &possibilities](const FactCombo &combo) {
+                          add_combo(loose, possibilities, combo);
+                          return loose.size() < CHECK_LIMIT;
+                        });
+  return true;
+}
+
+/*!
+  \brief Gives the clues of a puzzle one at a time through LiveLists and
+         compares its lists with those listed again after each clue
+
+  The positional clues come last, as in the phases of the benchmark, since
+  looking for combos with only a few of them takes long. The combos are
+  looked for after each clue until there are at most CHECK_LIMIT of them,
+  and then kept live.
+
+  \return The number of clues after which the lists differ
+*/
+int count_live_mismatches(const Puzzle &puzzle, TableType table_type) {
+  CspSolver solver(puzzle.num_values, puzzle.num_properties, table_type);
+  FactItems items = puzzle.make_items(solver);
+  LiveLists lists(solver);
+  const char *table = table_type == DENSE_TABLE ? "dense" : "pairwise";
+
+  std::vector<Clue> clues = puzzle.clues;
+  std::stable_partition(clues.begin(), clues.end(), [](const Clue &clue) {
+      return clue.type != RELATE;
+    });
+
+  int mismatches = 0;
+  for (std::size_t k = 0; k < clues.size(); ++k) {
+    const Clue &clue = clues[k];
+    FactItem *fact1 = items[clue.type1*puzzle.num_values + clue.value1].get();
+    FactItem *fact2 = items[clue.type2*puzzle.num_values + clue.value2].get();
+    switch (clue.type) {
+    case CONNECT:
+      lists.connect(fact1, fact2);
+      break;
+    case DISCONNECT:
+      lists.disconnect(fact1, fact2);
+      break;
+    case RELATE:
+      lists.relate(fact1, fact2, clue.property, clue.relation, clue.distance);
+      break;
+    }
+    if (!lists.has_combos()) {
+      lists.find_combos(CHECK_LIMIT);
+    }
+
+    PossibilityList possibilities;
+    Factoid factoid(puzzle.num_properties);
+    solver.get_possibilities(0, factoid, possibilities);
+    bool same = possibilities.size() == lists.possibilities().size();
+    for (std::size_t row = 0; same && row < possibilities.size(); ++row) {
+      same = possibilities[row] == lists.possibilities()[row];
+    }
+    if (same && lists.has_combos()) {
+      ComboList combo_list;
+      solver.get_unique_combos(combo_list, possibilities);
+      ComboSet combos;
+      for (ComboView combo : combo_list) {
+        add_combo(combos, possibilities, FactCombo(combo));
+      }
+      ComboSet live;
+      for (ComboView combo : lists.combos()) {
+        add_combo(live, lists.possibilities(), FactCombo(combo));
+      }
+      same = (combos == live);
+    }
+    if (!same) {
+      std::cerr << "benchmark: the live lists of a " << table
+                << " table differ after clue " << k << std::endl;
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+
+/*!
+  \brief Solves a puzzle every way there is and compares the combos
+
+  The mapped table is tried if scratch_path isn't empty. The combos without
+  the positional clues are only compared if there are fewer than
+  CHECK_LIMIT, since the engines stop at different ones. LiveLists is
+  checked on the dense and pairwise tables too.
+
+  \return The number of ways that disagree with the first one
+*/
+int count_mismatches(const Puzzle &puzzle, int num_threads,
+                     const std::string &scratch_path) {
+  std::vector<std::string> tables = {"dense", "pairwise"};
+  if (make_solver(puzzle.num_values, puzzle.num_properties, DENSE_TABLE,
+                  true, "")) {
+    tables.push_back("fixed");
+  }
+  if (!scratch_path.empty()) {
+    tables.push_back("mapped");
+  }
+
+  int mismatches = 0;
+  Variant reference;
+  ComboSet reference_combos;
+  ComboSet reference_loose;
+  bool first = true;
+  for (const std::string &table : tables) {
+    for (SearchEngine engine : {DANCING_LINKS, ENUMERATION, CDCL_SAT}) {
+      for (int options = 0; options < 4; ++options) {
+        const Variant variant = {table, engine, (options & 1) != 0,
+                                 (options & 2) != 0};
+        ComboSet combos;
+        ComboSet loose;
+        if (!solve_variant(puzzle, variant, num_threads, scratch_path,
+                           combos, loose)) {
+          std::cerr << "benchmark: can't make a " << variant.name()
+                    << " solver" << std::endl;
+          ++mismatches;
+        }
+        else if (first) {
+          reference = variant;
+          reference_combos = combos;
+          reference_loose = loose;
+          first = false;
+        }
+        else if (combos != reference_combos ||
+                 (loose.size() < CHECK_LIMIT &&
+                  reference_loose.size() < CHECK_LIMIT &&
+                  loose != reference_loose)) {
+          std::cerr << "benchmark: " << variant.name() << " finds "
+                    << combos.size() << " combos and " << loose.size()
+                    << " without the positional clues, "
+                    << reference.name() << " " << reference_combos.size()
+                    << " and " << reference_loose.size() << std::endl;
+          ++mismatches;
+        }
+      }
+    }
+  }
+  mismatches += count_live_mismatches(puzzle, DENSE_TABLE);
+  mismatches += count_live_mismatches(puzzle, PAIRWISE_TABLE);
+  return mismatches;
+}
+
+void usage() {
+  std::cerr << "Usage: benchmark [--values N] [--properties P] [--seed S]"
+            << std::endl
+            << "                 [--puzzles K]"
+            << " [--table dense|pairwise|fixed|mapped]"
+            << std::endl
+            << "                 [--scratch FILE, with --table mapped]"
+            << std::endl
+            << "                 [--engine dlx|enum|sat] [--threads T]"
+            << std::endl
+            << "                 [--propagate] [--minimal] [--write FILE]"
+            << std::endl
+            << "                 [--check]" << std::endl;
+  std::exit(1);
+}
+
+}
+
+int main(int argc, char* argv[])
+  {
+    int num_values = 5;
+    int num_properties = 5;
+    unsigned seed = 1;
+    int num_puzzles = 10;
+    TableType table_type = DENSE_TABLE;
+    bool fixed = false;
+    bool mapped = false;
+    std::string scratch_path;
+    SearchEngine engine = DANCING_LINKS;
+    int num_threads = 1;
+    bool propagate = false;
+    bool minimal = false;
+    bool check = false;
+    std::string write_path;
+
+    for (int i = 1; i < argc; ++i) {
+      const std::string option = argv[i];
+      if (option == "--propagate") {
+        propagate = true;
+        continue;
+      }
+      if (option == "--minimal") {
+        minimal = true;
+        continue;
+      }
+      if (option == "--check") {
+        check = true;
+        continue;
+      }
+      if (i + 1 == argc) {
+        usage();
+      }
+      const std::string value = argv[++i];
+      if (option == "--values") {
+        num_values = std::atoi(value.c_str());
+      }
+      else if (option == "--properties") {
+        num_properties = std::atoi(value.c_str());
+      }
+      else if (option == "--seed") {
+        seed = std::strtoul(value.c_str(), nullptr, 10);
+      }
+      else if (option == "--puzzles") {
+        num_puzzles = std::atoi(value.c_str());
+      }
+      else if (option == "--table" &&
+               (value == "dense" || value == "pairwise" ||
+                value == "fixed" || value == "mapped")) {
+        table_type = (value == "pairwise") ? PAIRWISE_TABLE : DENSE_TABLE;
+        fixed = (value == "fixed");
+        mapped = (value == "mapped");
+      }
+      else if (option == "--scratch") {
+        scratch_path = value;
+      }
+      else if (option == "--engine" && (value == "dlx" || value == "enum" ||
+                                        value == "sat")) {
+        engine = (value == "dlx") ? DANCING_LINKS :
+          (value == "enum") ? ENUMERATION : CDCL_SAT;
+      }
+      else if (option == "--threads") {
+        num_threads = std::atoi(value.c_str());
+      }
+      else if (option == "--write") {
+        write_path = value;
+      }
+      else {
+        usage();
+      }
+    }
+    if (table_type == DENSE_TABLE &&
+        !TruthTable::fits(num_values, num_properties)) {
+      std::cerr << "benchmark: " << num_values << "^" << num_properties
+                << " cells are too many for a dense table" << std::endl;
+      return 1;
+    }
+    // --scratch goes with --table mapped, or --check to try the mapped
+    // table too
+    if (num_values < 2 || num_values > MAX_VALUES || num_properties < 2 ||
+        num_puzzles < 1 ||
+        (mapped ? scratch_path.empty() : !scratch_path.empty() && !check) ||
+        (fixed && !make_solver(num_values, num_properties, table_type, fixed,
+                               ""))) {
+      usage();
+    }
+
+    Phase phases[NUM_PHASES] = {
+      {"generate", "puzzles", 0, 0},
+      {"setup", "tables", 0, 0},
+      {"clues", "clues", 0, 0},
+      {"relate", "clues", 0, 0},
+      {"filter", "combos", 0, 0},
+      {"propagate", "passes", 0, 0},
+      {"get_possibilities", "factoids", 0, 0},
+      {"get_unique_combos", "combos", 0, 0}};
+
+    std::vector<Puzzle> puzzles;
+    PuzzleGenerator generator(seed);
+    Clock::time_point start = Clock::now();
+    for (int k = 0; k < num_puzzles; ++k) {
+      puzzles.push_back(minimal ?
+                        generator.generate_minimal(num_values, num_properties,
+                                                   table_type) :
+                        generator.generate(num_values, num_properties,
+                                           table_type));
+    }
+    phases[PHASE_GENERATE].seconds = since(start);
+    phases[PHASE_GENERATE].ops = num_puzzles;
+
+    // Saves the puzzles for batch_solver
+    if (!write_path.empty()) {
+      std::ofstream out(write_path);
+      for (int k = 0; k < num_puzzles; ++k) {
+        puzzles[k].name = "random" + std::to_string(num_values) + "x" +
+                          std::to_string(num_properties) + "_" +
+                          std::to_string(seed) + "_" + std::to_string(k);
+        write_puzzle(out, puzzles[k]);
+      }
+      if (!out) {
+        std::cerr << "benchmark: can't write " << write_path << std::endl;
+        return 1;
+      }
+    }
+
+    int solved = 0;
+    int mismatches = 0;
+    long long num_clues = 0;
+    SolverStats solver_stats;
+    for (const Puzzle &puzzle : puzzles) {
+      start = Clock::now();
+      std::unique_ptr<CspSolver> made = make_solver(num_values, num_properties,
+                                                    table_type, fixed,
+                                                    mapped ? scratch_path : "");
+      if (!made) {
+        return 1;
+      }
+      CspSolver &solver = *made;
+      solver.set_search_engine(engine);
+      solver.set_num_threads(num_threads);
+      FactItems items = puzzle.make_items(solver);
+      phases[PHASE_SETUP].seconds += since(start);
+      ++phases[PHASE_SETUP].ops;
+
+      start = Clock::now();
+      for (const Clue &clue : puzzle.clues) {
+        if (clue.type != RELATE) {
+          puzzle.apply(solver, items, clue);
+          ++phases[PHASE_CLUES].ops;
+        }
+      }
+      phases[PHASE_CLUES].seconds += since(start);
+
+      // The combos of the other clues, for the positional clues to filter
+      PossibilityList unrelated;
+      Factoid factoid(num_properties);
+      solver.get_possibilities(0, factoid, unrelated);
+      ComboList unfiltered(num_values);
+      solver.for_each_combo(unrelated, [&unfiltered](const FactCombo &combo) {
+          unfiltered.push_back(combo);
+          return unfiltered.size() < FILTER_LIMIT;
+        });
+
+      // Positional clues are checked by the combo search, this only
+      // registers them
+      start = Clock::now();
+      for (const Clue &clue : puzzle.clues) {
+        if (clue.type == RELATE) {
+          puzzle.apply(solver, items, clue);
+          ++phases[PHASE_RELATE].ops;
+        }
+      }
+      phases[PHASE_RELATE].seconds += since(start);
+      num_clues += puzzle.clues.size();
+
+      start = Clock::now();
+      phases[PHASE_FILTER].ops += unfiltered.size();
+      solver.filter_combos(unfiltered, unrelated);
+      phases[PHASE_FILTER].seconds += since(start);
+
+      if (propagate) {
+        start = Clock::now();
+        solver.propagate();
+        phases[PHASE_PROPAGATE].seconds += since(start);
+        ++phases[PHASE_PROPAGATE].ops;
+      }
+
+      start = Clock::now();
+      PossibilityList possibilities;
+      solver.get_possibilities(0, factoid, possibilities);
+      phases[PHASE_POSSIBILITIES].seconds += since(start);
+      phases[PHASE_POSSIBILITIES].ops += possibilities.size();
+
+      start = Clock::now();
+      ComboList combo_list;
+      solver.get_unique_combos(combo_list, possibilities);
+      phases[PHASE_COMBOS].seconds += since(start);
+      phases[PHASE_COMBOS].ops += combo_list.size();
+
+      // Check the answer against the hidden solution
+      bool correct = (combo_list.size() == 1);
+      for (int house = 0; correct && house < num_values; ++house) {
+        const FactoidView factoid = possibilities[combo_list[0][house]];
+        for (int property = 0; property < num_properties; ++property) {
+          const int value = puzzle.solution[property][factoid[0]];
+          correct = correct && (factoid[property] == value);
+        }
+      }
+      solved += correct;
+      solver_stats.add(solver.get_stats());
+
+      if (check) {
+        mismatches += count_mismatches(puzzle, num_threads, scratch_path);
+      }
+    }
+
+    std::cout << "{" << std::endl
+              << "  \"values\": " << num_values << "," << std::endl
+              << "  \"properties\": " << num_properties << "," << std::endl
+              << "  \"seed\": " << seed << "," << std::endl
+              << "  \"puzzles\": " << num_puzzles << "," << std::endl
+              << "  \"clues_per_puzzle\": "
+              << double(num_clues)/num_puzzles << "," << std::endl
+              << "  \"table\": \""
+              << (fixed ? "fixed" : mapped ? "mapped" :
+                  table_type == DENSE_TABLE ? "dense" : "pairwise") << "\","
+              << std::endl
+              << "  \"engine\": \""
+              << (engine == DANCING_LINKS ? "dlx" :
+                  engine == ENUMERATION ? "enum" : "sat") << "\","
+              << std::endl
+              << "  \"threads\": " << num_threads << "," << std::endl
+              << "  \"minimal\": " << (minimal ? "true" : "false") << ","
+              << std::endl
+              << "  \"solved\": " << solved << "," << std::endl;
+    if (check) {
+      std::cout << "  \"mismatches\": " << mismatches << "," << std::endl;
+    }
+    std::cout << "  \"phases\": [" << std::endl;
+    for (int i = 0; i < NUM_PHASES; ++i) {
+      const Phase &phase = phases[i];
+      std::cout << "    {\"name\": \"" << phase.name << "\", \"seconds\": "
+                << phase.seconds << ", \"ops\": " << phase.ops
+                << ", \"unit\": \"" << phase.unit << "\", \"ops_per_sec\": "
+                << (phase.seconds > 0 ? phase.ops/phase.seconds : 0) << "}"
+                << (i + 1 < NUM_PHASES ? "," : "") << std::endl;
+    }
+    std::cout << "  ]," << std::endl
+              << "  \"solver_stats\": " << solver_stats.to_json() << ","
+              << std::endl
+              << "  \"peak_rss_kb\": " << peak_rss_kb() << std::endl
+              << "}" << std::endl;
+
+    return solved == num_puzzles && mismatches == 0 ? 0 : 1;
+  }
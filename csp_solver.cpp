@@ -1,16 +1,63 @@
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include "csp_solver.h"
+#include "truth_table.h"
+#include "exact_cover.h"
+#include "sat_cover.h"
+#include "value_symmetry.h"
 
 /*!
   \brief Constructs a new CSP (Constraint Satisfaction Problem) Solver
 
   \param num_categories Number of categories that we have
   \param num_properties Number of properties that each category can take
+  \param table_type DENSE_TABLE keeps all N^P cells, PAIRWISE_TABLE keeps one
+                    N x N matrix per property pair for large grids. A grid
+                    with more cells than can be counted is kept pairwise.
 */
-CspSolver::CspSolver(int num_categories, int num_properties) {
+CspSolver::CspSolver(int num_categories, int num_properties,
+                     TableType table_type)
+  : CspSolver(num_categories, num_properties,
+              table_type == PAIRWISE_TABLE ||
+              !TruthTable::fits(num_categories, num_properties) ?
+              std::unique_ptr<DomainStore>(new PairwiseTable(num_categories,
+                                                             num_properties)) :
+              std::unique_ptr<DomainStore>(new TruthTable(num_categories,
+                                                          num_properties))) {
+}
+
+/*!
+  \brief Constructs a solver that keeps the possibilities in a given store
+
+  The possibilities keep a value in a byte, so more than MAX_VALUES
+  categories are refused by aborting rather than cut to 8 bits. So are
+  fewer than two properties, since the clues pair values of two of them.
+
+  \param num_categories Number of categories that we have
+  \param num_properties Number of properties that each category can take
+  \param store A domain store of the same dimensions
+*/
+CspSolver::CspSolver(int num_categories, int num_properties,
+                     std::unique_ptr<DomainStore> store)
+  : truth_table(std::move(store)) {
+    if (num_categories > MAX_VALUES) {
+      std::cerr << "CspSolver: " << num_categories << " categories, at most "
+                << MAX_VALUES << " are supported" << std::endl;
+      std::abort();
+    }
+    if (num_properties < 2) {
+      std::cerr << "CspSolver: " << num_properties << " properties, at least"
+                << " 2 are needed" << std::endl;
+      std::abort();
+    }
     NUM_FACTS = num_categories;
     NUM_PROPERTIES = num_properties;
-    truth_table.resize(table_dimension(NUM_FACTS, NUM_PROPERTIES), true);
+    search_engine = DANCING_LINKS;
+    deterministic = true;
+    symmetry_breaking = false;
+    expand_symmetries = true;
+    control = nullptr;
     item_counter.resize(NUM_PROPERTIES, 0);
     std::vector<std::string> id_names;
     id_names.resize(NUM_FACTS, "");
@@ -34,94 +81,151 @@ FactItem* CspSolver::make_fact_item(int property, std::string name) {
 /*!
   \brief Connects two fact items
 
+  Two different items of one property can't be connected, so that clue
+  leaves neither of them any possibility and the puzzle no solution.
+
   \param[in] fact1 A pointer to FactItem 1
   \param[in] fact2 A pointer to FactItem 2
 */
 void CspSolver::connect( FactItem *fact1, FactItem *fact2)
 {
-  const int num_non_involved = NUM_PROPERTIES - 2;
-
-  // Re-map the indices, so that the properties that we are interested in
-  // are located in the end, so we can loop over the remaining ones.
-  Factoid remap;
-  remap.resize(NUM_PROPERTIES, NUM_PROPERTIES);
-
-  // Find the two properties that aren't involved here
-  int property_type = 0;
-  int index = 0;
-  while ( property_type < NUM_PROPERTIES) {
-    if (( fact1->type != property_type) && ( fact2->type != property_type)) {
-      remap[ index++ ] = property_type;
+  CSP_STATS_TIME(stats, clue_seconds);
+  CSP_STATS_ADD(stats, clues, 1);
+  if (fact1->type == fact2->type) {
+    if (fact1->value != fact2->value) {
+      rule_out(fact1->type, fact1->value);
+      rule_out(fact2->type, fact2->value);
     }
-    ++property_type;
+    return;
   }
+  truth_table->connect(fact1->type, fact1->value, fact2->type, fact2->value);
+}
 
-  // Add remaining (two) indices
-  for (int i = 0; i < NUM_PROPERTIES; ++i) {
-    // Find indices not used
-    auto it = find(remap.begin(), remap.end(), i);
-    if (it == remap.end()) {
-      remap[index++] = i;
-    }
-  }
+/*!
+  \brief Disconnects two fact items
 
-  Factoid loop;
-  loop.resize(NUM_PROPERTIES);
+  Different items of one property are disconnected already. An item can't
+  be disconnected from itself, so that clue leaves it no possibility.
 
-  if (fact1->type < fact2->type) {
-	  mark_false(num_non_involved, loop, fact1->value, fact2->value, remap);
-  }
-  else {
-	  mark_false(num_non_involved, loop, fact2->value, fact1->value, remap);
+  \param[in] fact1 A pointer to FactItem 1
+  \param[in] fact2 A pointer to FactItem 2
+*/
+void CspSolver::disconnect( FactItem *fact1, FactItem *fact2)
+{
+  CSP_STATS_TIME(stats, clue_seconds);
+  CSP_STATS_ADD(stats, clues, 1);
+  if (fact1->type == fact2->type) {
+    if (fact1->value == fact2->value) {
+      rule_out(fact1->type, fact1->value);
+    }
+    return;
   }
+  truth_table->disconnect(fact1->type, fact1->value,
+                          fact2->type, fact2->value);
 }
 
 /*!
-  \brief Disconnects two fact items
+  \brief Adds a positional clue between two fact items
+
+  The clue is checked inside get_unique_combos() as soon as both items have
+  been placed, instead of filtering the finished combos.
 
   \param[in] fact1 A pointer to FactItem 1
   \param[in] fact2 A pointer to FactItem 2
+  \param[in] property The ordinal property that positions are measured along,
+                      in the order its fact items were made
+  \param[in] relation How the position of fact2 relates to that of fact1
+  \param[in] distance The offset or distance for OFFSET and DISTANCE
 */
-void CspSolver::disconnect( FactItem *fact1, FactItem *fact2)
+void CspSolver::relate(FactItem *fact1, FactItem *fact2, int property,
+                       Relation relation, int distance)
+{
+  PositionalClue clue;
+  clue.type1 = fact1->type;
+  clue.value1 = fact1->value;
+  clue.type2 = fact2->type;
+  clue.value2 = fact2->value;
+  clue.property = property;
+  clue.relation = relation;
+  clue.distance = distance;
+  positional_clues.push_back(clue);
+}
+
+/*!
+  \brief Draws the conclusions that follow from the clues given so far
+
+  Pairs of values that no remaining combination supports, that leave a
+  positional clue without a partner, or that can't be matched one to one
+  with the other values of their properties, are disconnected. This is
+  repeated until nothing more can be concluded, which makes
+  get_possibilities() return fewer factoids.
+
+  \return false if the clues contradict each other
+*/
+bool CspSolver::propagate()
 {
-  // Re-map the indices, so that the properties that we are interested in
-  // are located in the end, so we can loop over the remaining ones.
-  Factoid remap;
-  remap.resize(NUM_PROPERTIES, NUM_PROPERTIES);
-
-  // Find the properties that aren't involved here
-  int property_type = 0;
-  int index = 0;
-  while ( property_type < NUM_PROPERTIES) {
-    if (( fact1->type != property_type) && ( fact2->type != property_type)) {
-      remap[ index++ ] = property_type;
+  CSP_STATS_TIME(stats, propagate_seconds);
+  PairwiseTable support(NUM_FACTS, NUM_PROPERTIES);
+  WordVector before;
+  while (true) {
+    CSP_STATS_ADD(stats, propagate_passes, 1);
+    truth_table->project(support);
+    before = support.state();
+    support.revise_paths();
+    revise_relations(support);
+    if (!support.all_different()) {
+      return false;
     }
-    ++property_type;
-  }
 
-  // Add remaining (two) indices
-  for (int i = 0; i < NUM_PROPERTIES; ++i) {
-    // Find indices not used
-    auto it = find(remap.begin(), remap.end(), i);
-    if (it == remap.end()) {
-      remap[index++] = i;
+    bool changed = false;
+    for (int i = 0; i < NUM_PROPERTIES; ++i) {
+      for (int j = i + 1; j < NUM_PROPERTIES; ++j) {
+        for (int x = 0; x < NUM_FACTS; ++x) {
+          for (int y = 0; y < NUM_FACTS; ++y) {
+            if (support.allowed(before, i, x, j, y) &&
+                !support.allowed(i, x, j, y)) {
+              truth_table->disconnect(i, x, j, y);
+              changed = true;
+            }
+          }
+        }
+      }
+    }
+    if (!changed) {
+      return true;
     }
   }
+}
 
-  Factoid loop;
-  loop.resize(NUM_PROPERTIES);
+/*!
+  \brief Remembers the current state so that later clues can be undone
 
-  const int num_non_involved = NUM_PROPERTIES - 2;
-  if (fact1->type < fact2->type) {
-	  loop[remap[ num_non_involved ]] = fact1->value;
-	  loop[remap[ num_non_involved + 1]] = fact2->value;
-  }
-  else {
-	  loop[remap[ num_non_involved ]] = fact2->value;
-	  loop[remap[ num_non_involved + 1]] = fact1->value;
-  }
+  Checkpoints nest. Until the matching rollback(), every word that a clue
+  or propagate() changes is saved, so trying a hypothesis costs as much as
+  the cells it clears instead of a copy of the table.
+*/
+void CspSolver::push_checkpoint()
+{
+  truth_table->push_checkpoint();
+  checkpoints.push_back(positional_clues.size());
+}
+
+/*!
+  \brief Undoes the clues given since the last checkpoint and drops it
+
+  Fact items made since the checkpoint are kept.
 
-  mark_false_all(num_non_involved, loop, remap);
+  \return false if there was no checkpoint
+*/
+bool CspSolver::rollback()
+{
+  if (checkpoints.empty()) {
+    return false;
+  }
+  truth_table->rollback();
+  positional_clues.resize(checkpoints.back());
+  checkpoints.pop_back();
+  return true;
 }
 
 /*!
@@ -129,10 +233,10 @@ void CspSolver::disconnect( FactItem *fact1, FactItem *fact2)
 
   \param[in] f1 Pointer to a known FactItem
   \param[in] property The other property that we want to find
-  \param[in] test_combo A FactCombo
+  \param[in] test_combo A fact combo, e.g. a row of a ComboList
   \param[in] possibility List of possibilities that test_combo is pointing to
 */
-int CspSolver::get_property(FactItem *f1, int property, FactCombo test_combo,
+int CspSolver::get_property(FactItem *f1, int property, ComboView test_combo,
 			    const PossibilityList &possibility) {
 
   int assignment = 0;
@@ -148,123 +252,566 @@ int CspSolver::get_property(FactItem *f1, int property, FactCombo test_combo,
 /*!
   \brief Filters out fact combos that are consistent with the clues
 
+  Positional clues added with relate() are checked during the search.
+
   \param[out] combo_list A list of indices in possibilities
   \param[in] possibility List of possibilities that combo_list members are
                          pointing to
 */
 void CspSolver::get_unique_combos(ComboList &combo_list,
 				  	  	  	  	  PossibilityList &possibilities) {
-  FactCombo test_combo;
-  test_combo.resize(NUM_FACTS);
-  check_unity(combo_list, 0, 0, possibilities.size(), test_combo,
-	      possibilities);
-}
+  if (!symmetry_breaking) {
+    search_combos(combo_list, possibilities, positional_clues);
+    return;
+  }
 
-void CspSolver::get_possibilities(int level, Factoid &factoid,
-				  	  	  	  	  PossibilityList &possibilities) {
-  if (level == NUM_PROPERTIES) {
-    if (truth_table[table_index(factoid)]) {
-      possibilities.push_back(factoid);
-    }
+  const ValueSymmetry symmetry(NUM_FACTS, NUM_PROPERTIES, possibilities,
+                               positional_clues);
+  std::vector<PositionalClue> clues = positional_clues;
+  symmetry.break_symmetries(clues);
+  if (!expand_symmetries || symmetry.empty()) {
+    search_combos(combo_list, possibilities, clues);
   }
   else {
-    for (factoid[level] = 0; factoid[level] < NUM_FACTS;
-	 ++factoid[level]) {
-      get_possibilities(level + 1, factoid, possibilities);
+    ComboList canonical;
+    search_combos(canonical, possibilities, clues);
+    const std::size_t first = combo_list.size();
+    for (ComboView combo : canonical) {
+      symmetry.expand(combo, [&combo_list](const FactCombo &image) {
+          combo_list.push_back(image);
+          return true;
+        });
     }
+    combo_list.sort(first);
+    CSP_STATS_MAX(stats, peak_list_bytes, combo_list.bytes());
+  }
+}
+
+/*!
+  \brief Lets get_unique_combos() search on several threads
+
+  \param[in] num_threads Number of threads, 0 for one per core and 1 to
+                         search serially
+  \param[in] deterministic Sort the merged combos so that the list is the
+                           same as from the serial search, otherwise they
+                           come in the order the threads finish
+*/
+void CspSolver::set_num_threads(int num_threads, bool deterministic)
+{
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
   }
+  pool.reset(num_threads > 1 ? new WorkStealingPool(num_threads) : nullptr);
+  this->deterministic = deterministic;
+}
+
+/*!
+  \brief Lets the searches skip combos that only differ in interchangeable
+         values
+
+  Values of a property that no positional clue tells apart and that the
+  possibilities treat alike, e.g. items that no clue mentions, are found
+  before each search, see ValueSymmetry. Only the combos where they come in
+  increasing order of property 0 are searched for, which saves a factor k!
+  for k such values.
+
+  \param[in] enabled Look for interchangeable values
+  \param[in] expand Give back every combo, as without symmetry breaking,
+                    otherwise only one per class of equivalent combos, see
+                    get_value_classes()
+*/
+void CspSolver::set_symmetry_breaking(bool enabled, bool expand)
+{
+  symmetry_breaking = enabled;
+  expand_symmetries = expand;
+}
+
+/*!
+  \brief Lets the combo searches and the listing of the possibilities be
+         stopped from outside
+
+  Every search engine charges the nodes it expands to the control and stops
+  when it says so, keeping the combos found so far. The domain store polls
+  it while it looks for possibilities. The searches then return as if they
+  had finished, the control tells them apart.
+
+  \param[in] control Shared with the threads that watch the search, must
+                     outlive it, or nullptr for no limits
+*/
+void CspSolver::set_search_control(SearchControl *control)
+{
+  this->control = control;
+  truth_table->set_control(control);
+}
+
+/*!
+  \brief Finds the classes of interchangeable values
+
+  \param[in] possibilities List of possibilities from get_possibilities()
+  \return The classes with more than one value, each canonical combo
+          stands for all orders of the values in each class
+*/
+std::vector<ValueClass> CspSolver::get_value_classes(
+  const PossibilityList &possibilities) const
+{
+  return ValueSymmetry(NUM_FACTS, NUM_PROPERTIES, possibilities,
+                       positional_clues).classes();
+}
+
+/*!
+  \brief Visits the fact combos that are consistent with the clues as they
+         are found
+
+  Each combo is sorted, but unlike get_unique_combos() the combos come in the
+  order the search finds them.
+
+  \param[in] possibilities List of possibilities that the combos point to
+  \param[in] visitor Called with each combo, returning false stops the search
+  \return The number of combos visited
+*/
+std::size_t CspSolver::for_each_combo(const PossibilityList &possibilities,
+                                      const ComboVisitor &visitor) {
+  CSP_STATS_TIME(stats, combo_seconds);
+  std::size_t count = 0;
+  auto counting = [&count, &visitor](const FactCombo &combo) {
+    ++count;
+    return visitor(combo);
+  };
+
+  if (!symmetry_breaking) {
+    visit_combos(possibilities, positional_clues, counting);
+    return count;
+  }
+
+  const ValueSymmetry symmetry(NUM_FACTS, NUM_PROPERTIES, possibilities,
+                               positional_clues);
+  std::vector<PositionalClue> clues = positional_clues;
+  symmetry.break_symmetries(clues);
+  if (!expand_symmetries || symmetry.empty()) {
+    visit_combos(possibilities, clues, counting);
+  }
+  else {
+    visit_combos(possibilities, clues,
+                 [&symmetry, &counting](const FactCombo &combo) {
+                   return symmetry.expand(combo, counting);
+                 });
+  }
+  return count;
+}
+
+/*!
+  \brief Drops the combos that break a positional clue
+
+  The searches check the positional clues as they go, this is for combos
+  found before some of the clues were given, e.g. to try several sets of
+  positional clues on the same combos. See RelationFilter.
+
+  \param[in,out] combo_list Complete combos, the ones that pass stay in
+                            order
+  \param[in] possibilities List of possibilities that the combos point to
+  \return The number of combos dropped
+*/
+std::size_t CspSolver::filter_combos(ComboList &combo_list,
+                                     const PossibilityList &possibilities) {
+  CSP_STATS_TIME(stats, combo_seconds);
+  const RelationFilter filter(positional_clues, possibilities);
+  ComboList survivors(combo_list.width());
+  const std::size_t dropped =
+    combo_list.size() - filter.filter(combo_list, survivors);
+  CSP_STATS_ADD(stats, relation_prunes, dropped);
+  combo_list = std::move(survivors);
+  return dropped;
+}
+
+/*!
+  \brief Counts the fact combos without storing them
+
+  \param[in] possibilities List of possibilities to combine
+  \param[in] limit Stop counting at this number, e.g. 2 to check whether a
+                   solution is unique, 0 counts all
+  \return The number of combos, at most limit
+*/
+std::size_t CspSolver::count_combos(const PossibilityList &possibilities,
+                                    std::size_t limit) {
+  std::size_t count = 0;
+  for_each_combo(possibilities, [&count, limit](const FactCombo &) {
+      return (++count != limit);
+    });
+  return count;
+}
+
+/*!
+  \brief Counts the solutions of the clues given so far
+
+  \param limit Stop counting at this number, 2 checks whether the solution
+               is unique without looking for more, 0 counts all
+  \return The number of solutions, at most limit
+*/
+std::size_t CspSolver::count_solutions(std::size_t limit) {
+  PossibilityList possibilities;
+  Factoid factoid(NUM_PROPERTIES);
+  get_possibilities(0, factoid, possibilities);
+  return count_combos(possibilities, limit);
+}
+
+/*!
+  \brief Lists the factoids that are consistent with the clues
+
+  \param[in] level Number of leading properties already fixed in factoid
+  \param[in,out] factoid Work space with one entry per property
+  \param[out] possibilities The factoids that are still possible
+*/
+void CspSolver::get_possibilities(int level, Factoid &factoid,
+				  	  	  	  	  PossibilityList &possibilities) {
+  CSP_STATS_TIME(stats, possibility_seconds);
+  truth_table->get_possibilities(level, factoid, possibilities);
+  CSP_STATS_MAX(stats, peak_list_bytes, possibilities.bytes());
+}
+
+/*!
+  \brief Visits the factoids that are consistent with the clues
+
+  \param[in] visitor Called with each factoid, returning false stops
+  \return The number of factoids visited
+*/
+std::size_t CspSolver::for_each_possibility(const FactoidVisitor &visitor) {
+  CSP_STATS_TIME(stats, possibility_seconds);
+  std::size_t count = 0;
+  Factoid factoid(NUM_PROPERTIES);
+  truth_table->visit_possibilities(0, factoid,
+                                   [&count, &visitor](const Factoid &f) {
+                                     ++count;
+                                     return visitor(f);
+                                   });
+  CSP_STATS_ADD(stats, possibilities, count);
+  return count;
+}
+
+/*!
+  \brief Checks whether the clues so far leave a factoid possible
+
+  Positional clues aren't checked, they concern whole combos.
+*/
+bool CspSolver::is_possible(const Factoid &factoid) const {
+  return truth_table->test(factoid);
 }
 
 std::string CspSolver::get_name(int property, int id) {
   return names[property][id];
 }
 
-// Private methods ----------------------------------------------
+/*!
+  \brief Selects the search behind get_unique_combos()
+
+  \param[in] engine DANCING_LINKS solves it as an exact cover problem,
+                    ENUMERATION tries every subset of the possibilities,
+                    CDCL_SAT hands the clues to a SAT solver that learns
+                    from its conflicts, which pays off on loosely clued
+                    puzzles with many possibilities. CDCL_SAT always
+                    searches on one thread.
+*/
+void CspSolver::set_search_engine(SearchEngine engine) {
+  search_engine = engine;
+}
+
+/*!
+  \brief Gets the statistics collected since construction or reset_stats()
+
+  They are only collected when the library is built with CSP_STATS, see
+  SolverStats::enabled().
+*/
+SolverStats CspSolver::get_stats() const {
+  SolverStats total = stats;
+  total.add(truth_table->get_stats());
+  return total;
+}
 
-int CspSolver::table_dimension(int num_categories,
-			       	   	   	   int num_properties) {
-  return (int)std::pow((float)num_categories, (float)num_properties);
+/*!
+  \brief Sets all statistics to zero, e.g. between phases of a benchmark
+*/
+void CspSolver::reset_stats() {
+  stats = SolverStats();
+  truth_table->reset_stats();
 }
 
-int CspSolver::table_index(const Factoid &f) {
-  int index = 0;
-  for (int i = 0; i < NUM_PROPERTIES; ++i) {
-    index += (int)std::pow((float)NUM_FACTS, (float)i)*f[i];
+// Private methods ----------------------------------------------
+
+/*!
+  \brief Leaves a value of a property no possibility, through the store so
+         that every backend agrees and rollback() undoes it
+*/
+void CspSolver::rule_out(int property, int value) {
+  const int other = (property == 0) ? 1 : 0;
+  for (int value2 = 0; value2 < NUM_FACTS; ++value2) {
+    truth_table->disconnect(property, value, other, value2);
   }
-  return index;
-}
-
-void CspSolver::mark_false(int level, Factoid &loop, const int value1,
-			   const int value2, const Factoid remap) {
-  const int num_non_involved = NUM_PROPERTIES - 2;
-
-  if (level == 0) {
-	  for (int i = 0; i < NUM_FACTS; ++i ) {
-		  if (i != value2 ) {
-			  Factoid property = loop;
-			  property[remap[NUM_PROPERTIES - 2]] = value1;
-			  property[remap[NUM_PROPERTIES - 1]] = i;
-			  truth_table[table_index(property)] = false;
-		  }
-	  }
-
-	  for (int i = 0; i < NUM_FACTS; ++i ) {
-		  if (i != value1 ) {
-			  Factoid property = loop;
-			  property[remap[NUM_PROPERTIES - 2]] = i;
-			  property[remap[NUM_PROPERTIES - 1]] = value2;
-			  truth_table[table_index(property)] = false;
-		  }
-	  }
+}
+
+/*!
+  \brief Adds factoids to a partial combo until it is complete
+
+  A factoid is only added if it shares no value with the factoids already in
+  the combo, so a complete combo has each value of each property once.
+
+  \param[in] used The (property, value) pairs of the partial combo
+  \param[in,out] counters Statistics of the thread doing the search
+*/
+template <class Mask>
+bool CspSolver::check_unity(const ComboVisitor &visitor, int level, int start,
+			    			int num_candidates, FactCombo &test_combo,
+							const FactoidMasks &masks, Mask &used,
+							RelationTracker &relations, SolverStats &counters) {
+  if (level == NUM_FACTS) {
+    CSP_STATS_ADD(counters, combos, 1);
+    return visitor(test_combo);
   }
-  else {
-    for (int i = 0; i < NUM_FACTS; ++i) {
-      loop[remap[num_non_involved - level]] = i;
-      mark_false(level - 1, loop, value1, value2, remap);
+  for (int j = start; j < num_candidates + level - NUM_FACTS + 1; ++j ) {
+    // Each possibility can only occur once
+    if (!used.fits(masks[j])) {
+      CSP_STATS_ADD(counters, clashes, 1);
+      continue;
+    }
+    if (control && level == 0) {
+      control->set_fraction(double(j)/num_candidates);
+    }
+    if (!relations.place(j)) {
+      CSP_STATS_ADD(counters, relation_prunes, 1);
+      continue;
+    }
+    if (control && !control->charge()) {
+      relations.remove(j);
+      return false;
+    }
+    CSP_STATS_ADD(counters, nodes, 1);
+    used.add(masks[j]);
+    test_combo[ level ] = j;
+    const bool go_on = check_unity(visitor, level + 1, j + 1, num_candidates,
+                                   test_combo, masks, used, relations,
+                                   counters);
+    used.remove(masks[j]);
+    relations.remove(j);
+    if (!go_on) {
+      return false;
     }
   }
+  return true;
 }
 
+/*!
+  \brief Completes the combos that start with the first level factoids of
+         test_combo, with one-word masks when the grid is small enough
+*/
+bool CspSolver::extend_combo(const ComboVisitor &visitor, int level,
+                             int num_candidates, FactCombo &test_combo,
+                             const FactoidMasks &masks,
+                             RelationTracker &relations,
+                             SolverStats &counters) {
+  const int start = level ? test_combo[level - 1] + 1 : 0;
+  if (masks.width() == 1) {
+    NarrowMask used(1);
+    for (int i = 0; i < level; ++i) {
+      used.add(masks[test_combo[i]]);
+    }
+    return check_unity(visitor, level, start, num_candidates, test_combo,
+                       masks, used, relations, counters);
+  }
+  WideMask used(masks.width());
+  for (int i = 0; i < level; ++i) {
+    used.add(masks[test_combo[i]]);
+  }
+  return check_unity(visitor, level, start, num_candidates, test_combo,
+                     masks, used, relations, counters);
+}
 
-void CspSolver::mark_false_all(int level, Factoid &loop, const Factoid remap) {
-  const int num_non_involved = NUM_PROPERTIES - 2;
-
-  if (level == 0) {
-    truth_table[table_index(loop)] = false;
+/*!
+  \brief Runs the search engine for get_unique_combos()
+*/
+void CspSolver::search_combos(ComboList &combo_list,
+                              const PossibilityList &possibilities,
+                              const std::vector<PositionalClue> &clues) {
+  if (pool && search_engine != CDCL_SAT) {
+    parallel_combos(combo_list, possibilities, clues);
+  }
+  else if (search_engine == CDCL_SAT) {
+    CSP_STATS_TIME(stats, combo_seconds);
+    SatCover sat_cover(NUM_FACTS, NUM_PROPERTIES, possibilities, clues);
+    sat_cover.set_control(control);
+    sat_cover.solve(combo_list);
+    stats.add(sat_cover.get_stats());
+  }
+  else if (search_engine == DANCING_LINKS) {
+    CSP_STATS_TIME(stats, combo_seconds);
+    ExactCover exact_cover(NUM_FACTS, NUM_PROPERTIES, possibilities, clues);
+    exact_cover.set_control(control);
+    exact_cover.solve(combo_list);
+    stats.add(exact_cover.get_stats());
   }
   else {
-    for (int i = 0; i < NUM_FACTS; ++i) {
-      loop[remap[num_non_involved - level]] = i;
-      mark_false_all(level - 1, loop, remap);
-    }
+    CSP_STATS_TIME(stats, combo_seconds);
+    visit_combos(possibilities, clues, [&combo_list](const FactCombo &combo) {
+        combo_list.push_back(combo);
+        return true;
+      });
   }
+  CSP_STATS_MAX(stats, peak_list_bytes, combo_list.bytes());
 }
 
+/*!
+  \brief Runs the search engine for for_each_combo()
+*/
+void CspSolver::visit_combos(const PossibilityList &possibilities,
+                             const std::vector<PositionalClue> &clues,
+                             const ComboVisitor &visitor) {
+  if (search_engine == DANCING_LINKS) {
+    ExactCover exact_cover(NUM_FACTS, NUM_PROPERTIES, possibilities, clues);
+    exact_cover.set_control(control);
+    exact_cover.solve(visitor);
+    stats.add(exact_cover.get_stats());
+  }
+  else if (search_engine == CDCL_SAT) {
+    SatCover sat_cover(NUM_FACTS, NUM_PROPERTIES, possibilities, clues);
+    sat_cover.set_control(control);
+    sat_cover.solve(visitor);
+    stats.add(sat_cover.get_stats());
+  }
+  else {
+    FactCombo test_combo;
+    test_combo.resize(NUM_FACTS);
+    RelationTracker relations(clues, possibilities);
+    FactoidMasks masks(NUM_FACTS, NUM_PROPERTIES, possibilities);
+    extend_combo(visitor, 0, possibilities.size(), test_combo, masks,
+                 relations, stats);
+  }
+}
 
+void CspSolver::parallel_combos(ComboList &combo_list,
+                                const PossibilityList &possibilities,
+                                const std::vector<PositionalClue> &clues) {
+  CSP_STATS_TIME(stats, combo_seconds);
+  const int num_workers = pool->size();
+  std::vector<ComboList> found(num_workers);
+  std::vector<SolverStats> counters(num_workers);
+  const std::size_t first = combo_list.size();
+
+  // Subtrees searched, for the fraction of the tree explored
+  std::atomic<std::size_t> finished(0);
+
+  if (search_engine == DANCING_LINKS) {
+    // Go deep enough to give the thieves something to steal
+    std::vector<FactCombo> prefixes;
+    {
+      ExactCover exact_cover(NUM_FACTS, NUM_PROPERTIES, possibilities, clues);
+      exact_cover.set_control(control);
+      int depth = 0;
+      do {
+        prefixes.clear();
+        exact_cover.split(++depth, prefixes);
+      } while (!prefixes.empty() &&
+               prefixes.size() < 8*(std::size_t)num_workers &&
+               depth < NUM_FACTS);
+    }
 
-void CspSolver::check_unity(ComboList &combo_list, int level, int start,
-			    			int num_candidates, FactCombo &test_combo,
-							const PossibilityList &possibility) {
-  if (level == NUM_FACTS) {
-    bool unique = true;
-    int property = -1;
-    int counter[NUM_FACTS] = {0};
-    while ( unique && ( ++property < NUM_PROPERTIES)) {
-      int assignment = -1;
-      while ( unique && ( ++assignment < NUM_FACTS )) {
-        // Each possibility can only occur once
-        unique = ( (counter[ possibility[ test_combo[ assignment ] ][ property ] ])++ < 1 );
-      }
-      memset(counter, 0, NUM_FACTS*sizeof(int));
+    std::vector<std::unique_ptr<ExactCover>> covers(num_workers);
+    for (const FactCombo &prefix : prefixes) {
+      pool->submit([&, prefix](int worker) {
+          if (control && control->stopped()) {
+            return;
+          }
+          if (!covers[worker]) {
+            covers[worker].reset(new ExactCover(NUM_FACTS, NUM_PROPERTIES,
+                                                possibilities,
+                                                clues));
+            covers[worker]->set_control(control);
+          }
+          ComboList &mine = found[worker];
+          covers[worker]->solve(prefix, [&mine](const FactCombo &combo) {
+              mine.push_back(combo);
+              return true;
+            });
+          if (control) {
+            control->set_fraction(double(++finished)/prefixes.size());
+          }
+        });
     }
-    if ( unique ) {
-	combo_list.push_back(test_combo);
+    pool->wait();
+    for (const std::unique_ptr<ExactCover> &cover : covers) {
+      if (cover) {
+        stats.add(cover->get_stats());
+      }
     }
   }
   else {
-    for (int j = start; j < num_candidates + level - NUM_FACTS + 1; ++j ) {
-      test_combo[ level ] = j;
-      check_unity(combo_list, level + 1, j + 1, num_candidates, test_combo, possibility);
+    // Each choice of the first factoid is an independent subtree
+    std::vector<std::unique_ptr<RelationTracker>> trackers(num_workers);
+    const FactoidMasks masks(NUM_FACTS, NUM_PROPERTIES, possibilities);
+    const int num_candidates = possibilities.size();
+    for (int j = 0; j < num_candidates - NUM_FACTS + 1; ++j) {
+      pool->submit([&, j](int worker) {
+          if (control && control->stopped()) {
+            return;
+          }
+          if (!trackers[worker]) {
+            trackers[worker].reset(new RelationTracker(clues,
+                                                       possibilities));
+          }
+          RelationTracker &relations = *trackers[worker];
+          if (!relations.place(j)) {
+            CSP_STATS_ADD(counters[worker], relation_prunes, 1);
+            return;
+          }
+          CSP_STATS_ADD(counters[worker], nodes, 1);
+          ComboList &mine = found[worker];
+          FactCombo test_combo(NUM_FACTS);
+          test_combo[0] = j;
+          extend_combo([&mine](const FactCombo &combo) {
+              mine.push_back(combo);
+              return true;
+            }, 1, num_candidates, test_combo, masks, relations,
+            counters[worker]);
+          relations.remove(j);
+          if (control) {
+            control->set_fraction(double(++finished)/num_candidates);
+          }
+        });
+    }
+    pool->wait();
+  }
+
+  for (int worker = 0; worker < num_workers; ++worker) {
+    combo_list.append(found[worker]);
+    stats.add(counters[worker]);
+  }
+  if (deterministic) {
+    combo_list.sort(first);
+  }
+}
+
+void CspSolver::revise_relations(PairwiseTable &support) {
+  std::vector<bool> ordinals1(NUM_FACTS);
+  std::vector<bool> ordinals2(NUM_FACTS);
+  for (const PositionalClue &clue : positional_clues) {
+    // The positions that each item can still take
+    for (int k = 0; k < NUM_FACTS; ++k) {
+      ordinals1[k] = (clue.type1 == clue.property) ? (k == clue.value1) :
+        support.allowed(clue.type1, clue.value1, clue.property, k);
+      ordinals2[k] = (clue.type2 == clue.property) ? (k == clue.value2) :
+        support.allowed(clue.type2, clue.value2, clue.property, k);
+    }
+
+    // A position needs a position of the other item that fulfils the clue
+    for (int k1 = 0; k1 < NUM_FACTS; ++k1) {
+      bool partner1 = false;
+      bool partner2 = false;
+      for (int k2 = 0; k2 < NUM_FACTS; ++k2) {
+        partner1 = partner1 || (ordinals2[k2] && clue.holds(k1, k2));
+        partner2 = partner2 || (ordinals1[k2] && clue.holds(k2, k1));
+      }
+      if (ordinals1[k1] && !partner1 && clue.type1 != clue.property) {
+        support.disconnect(clue.type1, clue.value1, clue.property, k1);
+      }
+      if (ordinals2[k1] && !partner2 && clue.type2 != clue.property) {
+        support.disconnect(clue.type2, clue.value2, clue.property, k1);
+      }
     }
   }
 }
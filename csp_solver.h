@@ -1,15 +1,28 @@
+#ifndef CSP_SOLVER_H
+#define CSP_SOLVER_H
+
 #include <iostream>
 #include <string>
 #include <cstring>
 #include <array>
 #include <cmath>
 #include <vector>
+#include <memory>
+#include "csp_types.h"
+#include "domain_store.h"
+#include "relations.h"
+#include "search_control.h"
+#include "factoid_masks.h"
+#include "solver_stats.h"
+#include "pairwise_table.h"
+#include "thread_pool.h"
+#include "fixed_truth_table.h"
+#include "value_symmetry.h"
 
-typedef std::vector<bool> TruthTable;
-typedef std::vector<int> Factoid;
-typedef std::vector<int> FactCombo;
-typedef std::vector<FactCombo> ComboList;
-typedef std::vector<Factoid> PossibilityList;
+typedef enum {
+  DANCING_LINKS = 0,
+  ENUMERATION,
+  CDCL_SAT} SearchEngine;
 
 class FactItem {
 
@@ -26,34 +39,105 @@ class CspSolver {
 
 public:
 
-  CspSolver(int num_categories, int num_properties);
+  CspSolver(int num_categories, int num_properties,
+            TableType table_type = DENSE_TABLE);
+  CspSolver(int num_categories, int num_properties,
+            std::unique_ptr<DomainStore> store);
+  virtual ~CspSolver() {}
   FactItem* make_fact_item(int category, std::string name);
   void connect( FactItem *fact1, FactItem *fact2);
   void disconnect( FactItem *fact1, FactItem *fact2);
-  int get_property(FactItem *f1, int property, FactCombo test_combo,
+  void relate(FactItem *fact1, FactItem *fact2, int property,
+              Relation relation, int distance = 0);
+  bool propagate();
+  void push_checkpoint();
+  bool rollback();
+  int get_property(FactItem *f1, int property, ComboView test_combo,
 		   const PossibilityList &possibility);
   void get_unique_combos(ComboList &combo_list, PossibilityList &possibilities);
   void get_possibilities(int level, Factoid &factoid,
 			 PossibilityList &possibilities);
+  std::size_t for_each_possibility(const FactoidVisitor &visitor);
+  std::size_t for_each_combo(const PossibilityList &possibilities,
+                             const ComboVisitor &visitor);
+  std::size_t filter_combos(ComboList &combo_list,
+                            const PossibilityList &possibilities);
+  std::size_t count_combos(const PossibilityList &possibilities,
+                           std::size_t limit = 0);
+  std::size_t count_solutions(std::size_t limit = 0);
   std::string get_name(int category, int property);
-
+  int num_values() const { return NUM_FACTS; }
+  int num_properties() const { return NUM_PROPERTIES; }
+  bool is_possible(const Factoid &factoid) const;
+  void set_search_engine(SearchEngine engine);
+  void set_num_threads(int num_threads, bool deterministic = true);
+  void set_symmetry_breaking(bool enabled, bool expand = true);
+  void set_search_control(SearchControl *control);
+  std::vector<ValueClass> get_value_classes(
+    const PossibilityList &possibilities) const;
+  SolverStats get_stats() const;
+  void reset_stats();
 
 private:
 
+  friend class SolverSnapshot;
+
   int NUM_FACTS;
   int NUM_PROPERTIES;
 
+  SearchEngine search_engine;
+  std::unique_ptr<WorkStealingPool> pool;
+  bool deterministic;
+  bool symmetry_breaking;
+  bool expand_symmetries;
+  SearchControl *control;
+
+  std::vector<PositionalClue> positional_clues;
+  SolverStats stats;
+
+  // Number of positional clues at each open checkpoint
+  std::vector<std::size_t> checkpoints;
+
   std::vector<int> item_counter;
-  TruthTable truth_table;
+  std::unique_ptr<DomainStore> truth_table;
   std::vector<std::vector<std::string>> names;
 
-  int table_dimension(int num_fact_items, int num_properties);
-  int table_index(const Factoid &f);
-  void check_unity(ComboList &combo_list, int level, int start,
+  template <class Mask>
+  bool check_unity(const ComboVisitor &visitor, int level, int start,
 		   int num_candidates, FactCombo &test_combo,
-		   const PossibilityList &possibility);
-  void mark_false(int level, Factoid &loop, const int value1,
-		  const int value2, const Factoid remap);
-  void mark_false_all(int level, Factoid &loop, const Factoid remap);
+		   const FactoidMasks &masks, Mask &used, RelationTracker &relations,
+		   SolverStats &counters);
+  bool extend_combo(const ComboVisitor &visitor, int level, int num_candidates,
+                    FactCombo &test_combo, const FactoidMasks &masks,
+                    RelationTracker &relations, SolverStats &counters);
+  void search_combos(ComboList &combo_list,
+                     const PossibilityList &possibilities,
+                     const std::vector<PositionalClue> &clues);
+  void visit_combos(const PossibilityList &possibilities,
+                    const std::vector<PositionalClue> &clues,
+                    const ComboVisitor &visitor);
+  void parallel_combos(ComboList &combo_list,
+                       const PossibilityList &possibilities,
+                       const std::vector<PositionalClue> &clues);
+  void revise_relations(PairwiseTable &support);
+  void rule_out(int property, int value);
   void print(const Factoid &f);
 };
+
+/*!
+  \brief A CspSolver for puzzles of one shape, N values and P properties
+
+  It has the same interface as CspSolver and can be used wherever one is
+  expected, but keeps the possibilities in a FixedTruthTable.
+*/
+template <int N, int P>
+class FixedCspSolver : public CspSolver {
+
+public:
+
+  FixedCspSolver()
+    : CspSolver(N, P, std::unique_ptr<DomainStore>(new FixedTruthTable<N, P>))
+  {}
+};
+
+#endif
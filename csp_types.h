@@ -0,0 +1,199 @@
+#ifndef CSP_TYPES_H
+#define CSP_TYPES_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+typedef std::vector<int> Factoid;
+typedef std::vector<int> FactCombo;
+
+/*!
+  \brief A read-only view of one row of a PackedList
+*/
+template <class T>
+class RowView {
+
+public:
+
+  RowView(const T *fields, int length) : fields(fields), length(length) {}
+
+  int operator[](int i) const { return fields[i]; }
+  int size() const { return length; }
+  const T *begin() const { return fields; }
+  const T *end() const { return fields + length; }
+
+  bool operator==(const RowView &other) const {
+    return std::equal(begin(), end(), other.begin(), other.end());
+  }
+  bool operator<(const RowView &other) const {
+    return std::lexicographical_compare(begin(), end(),
+                                        other.begin(), other.end());
+  }
+  operator std::vector<int>() const { return std::vector<int>(begin(), end()); }
+
+private:
+
+  const T *fields;
+  int length;
+};
+
+/*!
+  \brief Rows of equal length stored back to back in one buffer
+
+  The row length is taken from the first row pushed, unless given at
+  construction. Indexing and iterating give RowViews into the buffer, which
+  stay valid until the list grows.
+
+  A list made by view() reads its rows from memory that it doesn't own,
+  e.g. a mapped file, and only copies them when it is first changed.
+*/
+template <class T>
+class PackedList {
+
+public:
+
+  typedef RowView<T> View;
+
+  class const_iterator {
+
+  public:
+
+    const_iterator(const T *fields, int stride)
+      : fields(fields), stride(stride) {}
+
+    View operator*() const { return View(fields, stride); }
+    const_iterator &operator++() { fields += stride; return *this; }
+    bool operator!=(const const_iterator &other) const {
+      return fields != other.fields;
+    }
+
+  private:
+
+    const T *fields;
+    int stride;
+  };
+
+  explicit PackedList(int width = 0)
+    : stride(width), external(nullptr), external_size(0) {}
+
+  /*!
+    \brief Makes a list of rows stored elsewhere
+
+    \param fields The rows back to back, which must outlive the list
+    \param rows Number of rows
+    \param width Length of each row
+  */
+  static PackedList view(const T *fields, std::size_t rows, int width) {
+    PackedList list(width);
+    list.external = fields;
+    list.external_size = rows*width;
+    return list;
+  }
+
+  std::size_t size() const { return stride ? length()/stride : 0; }
+  bool empty() const { return !length(); }
+  int width() const { return stride; }
+  const T *data() const { return external ? external : fields.data(); }
+  std::size_t bytes() const { return fields.capacity()*sizeof(T); }
+
+  View operator[](std::size_t row) const {
+    return View(data() + row*stride, stride);
+  }
+  const_iterator begin() const { return const_iterator(data(), stride); }
+  const_iterator end() const {
+    return const_iterator(data() + length(), stride);
+  }
+
+  void push_back(const std::vector<int> &row) {
+    own();
+    if (!stride) {
+      stride = row.size();
+    }
+    assert((int)row.size() == stride);
+    fields.insert(fields.end(), row.begin(), row.end());
+  }
+
+  void push_back(const View &row) {
+    own();
+    if (!stride) {
+      stride = row.size();
+    }
+    assert((int)row.size() == stride);
+    fields.insert(fields.end(), row.begin(), row.end());
+  }
+
+  void append(const PackedList &other) {
+    own();
+    if (!stride) {
+      stride = other.stride;
+    }
+    assert(other.empty() || other.stride == stride);
+    fields.insert(fields.end(), other.data(), other.data() + other.length());
+  }
+
+  void clear() {
+    external = nullptr;
+    external_size = 0;
+    fields.clear();
+  }
+
+  /*!
+    \brief Sorts the rows from first onwards in lexicographic order
+  */
+  void sort(std::size_t first = 0) {
+    own();
+    std::vector<std::size_t> order(size() - first);
+    std::iota(order.begin(), order.end(), first);
+    std::sort(order.begin(), order.end(),
+              [this](std::size_t a, std::size_t b) {
+                return (*this)[a] < (*this)[b];
+              });
+    std::vector<T> sorted(fields.begin(), fields.begin() + first*stride);
+    sorted.reserve(fields.size());
+    for (std::size_t row : order) {
+      sorted.insert(sorted.end(), fields.begin() + row*stride,
+                    fields.begin() + (row + 1)*stride);
+    }
+    fields.swap(sorted);
+  }
+
+private:
+
+  int stride;
+  std::vector<T> fields;
+
+  // The rows of a view, fields is empty until they are copied
+  const T *external;
+  std::size_t external_size;
+
+  std::size_t length() const {
+    return external ? external_size : fields.size();
+  }
+
+  void own() {
+    if (external) {
+      fields.assign(external, external + external_size);
+      external = nullptr;
+      external_size = 0;
+    }
+  }
+};
+
+// A factoid has one byte per property, so at most 256 values per property
+const int MAX_VALUES = 256;
+
+typedef RowView<uint8_t> FactoidView;
+typedef RowView<int> ComboView;
+typedef PackedList<uint8_t> PossibilityList;
+typedef PackedList<int> ComboList;
+
+// Called for each result as it is found, returning false stops the search
+typedef std::function<bool(const Factoid &)> FactoidVisitor;
+typedef std::function<bool(const FactCombo &)> ComboVisitor;
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef DOMAIN_STORE_H
+#define DOMAIN_STORE_H
+
+#include <algorithm>
+#include "csp_types.h"
+#include "search_control.h"
+#include "solver_stats.h"
+#include "trail.h"
+
+class PairwiseTable;
+
+typedef enum {
+  DENSE_TABLE = 0,
+  PAIRWISE_TABLE} TableType;
+
+/*!
+  \brief Storage of the combinations that are still possible
+
+  A backend only needs to know how to apply the individual clues and how to
+  visit the factoids that survive them. The CspSolver picks one at
+  construction. The clues it passes on are between two different
+  properties.
+*/
+class DomainStore {
+
+public:
+
+  DomainStore() : control(nullptr) {}
+  virtual ~DomainStore() {}
+
+  virtual void connect(int property1, int value1,
+                       int property2, int value2) = 0;
+  virtual void disconnect(int property1, int value1,
+                          int property2, int value2) = 0;
+  virtual bool test(const Factoid &factoid) const = 0;
+  virtual bool visit_possibilities(int level, Factoid &factoid,
+                                   const FactoidVisitor &visitor) const = 0;
+  virtual void project(PairwiseTable &support) const = 0;
+  virtual TableType table_type() const = 0;
+
+  void get_possibilities(int level, Factoid &factoid,
+                         PossibilityList &possibilities) const {
+    visit_possibilities(level, factoid,
+                        [this, &possibilities](const Factoid &possibility) {
+                          CSP_STATS_ADD(stats, possibilities, 1);
+                          possibilities.push_back(possibility);
+                          return true;
+                        });
+  }
+
+  /*!
+    \brief Lets visit_possibilities() be stopped from outside, nullptr for
+           no limits
+
+    The backends poll the control as they move on, also while they find
+    nothing, and return false once it says to stop.
+  */
+  void set_control(SearchControl *control) { this->control = control; }
+
+  const SolverStats &get_stats() const { return stats; }
+  void reset_stats() { stats = SolverStats(); }
+
+  /*!
+    \brief Starts recording the changes made by the clues
+  */
+  void push_checkpoint() { trail.push(); }
+
+  /*!
+    \brief Undoes the clues since the last checkpoint and drops it
+
+    \return false if there was no checkpoint
+  */
+  virtual bool rollback() { return trail.pop(bits()); }
+
+  /*!
+    \brief The words that hold the state of the store, e.g. for a snapshot
+  */
+  const WordVector &state() const { return bits(); }
+
+  /*!
+    \brief Replaces the state with words saved from a store of the same kind
+
+    \return false if the number of words differs or a checkpoint is open
+  */
+  virtual bool set_state(const uint64_t *state, std::size_t num_words) {
+    WordVector &words = bits();
+    if (trail.active() || num_words != words.size()) {
+      return false;
+    }
+    std::copy(state, state + num_words, words.begin());
+    return true;
+  }
+
+protected:
+
+  // Cells cleared by the clues and visited for the possibilities
+  mutable SolverStats stats;
+  Trail trail;
+  SearchControl *control;
+
+  /*!
+    \brief Polls the control, if any
+
+    \return true if the visit must stop
+  */
+  bool interrupted() const { return control && !control->poll(); }
+
+  // The words that hold the state of the store
+  virtual WordVector &bits() = 0;
+  virtual const WordVector &bits() const = 0;
+
+  /*!
+    \brief Clears bits of a word, saving it first if a checkpoint is open
+  */
+  void clear_bits(WordVector &words, std::size_t w,
+                  uint64_t cleared) {
+    if (words[w] & cleared) {
+      CSP_STATS_ADD(stats, cells_cleared,
+                    __builtin_popcountll(words[w] & cleared));
+      trail.save(w, words[w]);
+      words[w] &= ~cleared;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include "exact_cover.h"
+
+/*!
+  \brief Builds the sparse cover matrix for a list of factoids
+
+  \param num_values Number of values that each property can take
+  \param num_properties Number of properties
+  \param possibilities The factoids, i.e. the rows of the matrix
+  \param clues Positional clues that the combos must satisfy
+*/
+ExactCover::ExactCover(int num_values, int num_properties,
+                       const PossibilityList &possibilities,
+                       const std::vector<PositionalClue> &clues)
+  : relations(clues, possibilities), control(nullptr), from_root(false) {
+  NUM_VALUES = num_values;
+  NUM_PROPERTIES = num_properties;
+  solution.resize(NUM_VALUES);
+  combo.resize(NUM_VALUES);
+  branches_done.resize(PROGRESS_LEVELS, 0);
+  branches_total.resize(PROGRESS_LEVELS, 1);
+
+  const int num_columns = NUM_PROPERTIES*NUM_VALUES;
+  nodes.reserve(1 + num_columns + possibilities.size()*NUM_PROPERTIES);
+  column_size.resize(num_columns + 1, 0);
+  row_node.resize(possibilities.size(), -1);
+
+  for (int c = 0; c <= num_columns; ++c) {
+    Node header;
+    header.left = (c == 0) ? num_columns : c - 1;
+    header.right = (c == num_columns) ? 0 : c + 1;
+    header.up = c;
+    header.down = c;
+    header.column = c;
+    header.row = -1;
+    nodes.push_back(header);
+  }
+
+  for (int row = 0; row < (int)possibilities.size(); ++row) {
+    const FactoidView factoid = possibilities[row];
+    bool in_range = true;
+    for (int property = 0; property < NUM_PROPERTIES; ++property) {
+      in_range = in_range && (factoid[property] >= 0) &&
+        (factoid[property] < NUM_VALUES);
+    }
+    if (!in_range || !relations.feasible(row)) {
+      continue;
+    }
+
+    const int first = nodes.size();
+    row_node[row] = first;
+    for (int property = 0; property < NUM_PROPERTIES; ++property) {
+      const int column = 1 + property*NUM_VALUES + factoid[property];
+      Node node;
+      node.left = (property == 0) ? first + NUM_PROPERTIES - 1 :
+        first + property - 1;
+      node.right = (property == NUM_PROPERTIES - 1) ? first :
+        first + property + 1;
+      node.up = nodes[column].up;
+      node.down = column;
+      node.column = column;
+      node.row = row;
+      const int index = nodes.size();
+      nodes[nodes[column].up].down = index;
+      nodes[column].up = index;
+      nodes.push_back(node);
+      ++column_size[column];
+    }
+  }
+}
+
+/*!
+  \brief Finds all exact covers
+
+  \param[out] combo_list The combos, each sorted and in lexicographic order,
+                         so the list is the same as from brute force
+*/
+void ExactCover::solve(ComboList &combo_list) {
+  const std::size_t first = combo_list.size();
+  solve([&combo_list](const FactCombo &combo) {
+      combo_list.push_back(combo);
+      return true;
+    });
+  combo_list.sort(first);
+}
+
+/*!
+  \brief Visits the exact covers in the order they are found
+
+  Nothing is allocated per combo, the visitor gets a sorted work buffer.
+
+  \param[in] visitor Called with each combo, returning false stops the search
+  \return false if the visitor stopped the search
+*/
+bool ExactCover::solve(const ComboVisitor &visitor) {
+  from_root = true;
+  const bool go_on = search(0, visitor);
+  from_root = false;
+  return go_on;
+}
+
+/*!
+  \brief Splits the search tree into independent subtrees
+
+  The subtrees are listed in the order the serial search visits them, so
+  solving them one after the other gives the same combos in the same order.
+
+  \param[in] depth Number of rows to choose before a subtree starts
+  \param[out] prefixes The rows chosen on the way to each subtree
+*/
+void ExactCover::split(int depth, std::vector<FactCombo> &prefixes) {
+  branch(0, depth, prefixes);
+}
+
+/*!
+  \brief Visits the exact covers in one subtree from split()
+
+  \param[in] prefix The rows chosen on the way to the subtree
+  \param[in] visitor Called with each combo, returning false stops the search
+  \return false if the visitor stopped the search
+*/
+bool ExactCover::solve(const FactCombo &prefix, const ComboVisitor &visitor) {
+  for (std::size_t level = 0; level < prefix.size(); ++level) {
+    relations.place(prefix[level]);
+    solution[level] = prefix[level];
+    select(prefix[level]);
+  }
+  const bool go_on = search(prefix.size(), visitor);
+  for (std::size_t level = prefix.size(); level-- > 0; ) {
+    deselect(prefix[level]);
+    relations.remove(prefix[level]);
+  }
+  return go_on;
+}
+
+// Private methods ----------------------------------------------
+
+void ExactCover::cover(int column) {
+  nodes[nodes[column].right].left = nodes[column].left;
+  nodes[nodes[column].left].right = nodes[column].right;
+  for (int i = nodes[column].down; i != column; i = nodes[i].down) {
+    for (int j = nodes[i].right; j != i; j = nodes[j].right) {
+      nodes[nodes[j].down].up = nodes[j].up;
+      nodes[nodes[j].up].down = nodes[j].down;
+      --column_size[nodes[j].column];
+    }
+  }
+}
+
+void ExactCover::uncover(int column) {
+  for (int i = nodes[column].up; i != column; i = nodes[i].up) {
+    for (int j = nodes[i].left; j != i; j = nodes[j].left) {
+      ++column_size[nodes[j].column];
+      nodes[nodes[j].down].up = j;
+      nodes[nodes[j].up].down = j;
+    }
+  }
+  nodes[nodes[column].right].left = column;
+  nodes[nodes[column].left].right = column;
+}
+
+void ExactCover::select(int row) {
+  const int first = row_node[row];
+  cover(nodes[first].column);
+  for (int j = nodes[first].right; j != first; j = nodes[j].right) {
+    cover(nodes[j].column);
+  }
+}
+
+void ExactCover::deselect(int row) {
+  const int first = row_node[row];
+  for (int j = nodes[first].left; j != first; j = nodes[j].left) {
+    uncover(nodes[j].column);
+  }
+  uncover(nodes[first].column);
+}
+
+int ExactCover::choose_column() const {
+  int column = nodes[0].right;
+  for (int c = nodes[column].right; c != 0; c = nodes[c].right) {
+    if (column_size[c] < column_size[column]) {
+      column = c;
+    }
+  }
+  return column;
+}
+
+bool ExactCover::search(int level, const ComboVisitor &visitor) {
+  if (nodes[0].right == 0) {
+    std::copy(solution.begin(), solution.begin() + level, combo.begin());
+    std::sort(combo.begin(), combo.end());
+    CSP_STATS_ADD(stats, combos, 1);
+    return visitor(combo);
+  }
+
+  // Branch on the most constrained column
+  const int column = choose_column();
+  if (column_size[column] == 0) {
+    CSP_STATS_ADD(stats, clashes, 1);
+    return true;
+  }
+
+  if (control && from_root && level < PROGRESS_LEVELS) {
+    branches_done[level] = 0;
+    branches_total[level] = column_size[column];
+  }
+  cover(column);
+  for (int r = nodes[column].down; r != column; r = nodes[r].down) {
+    if (!relations.place(nodes[r].row)) {
+      CSP_STATS_ADD(stats, relation_prunes, 1);
+      branch_done(level);
+      continue;
+    }
+    if (control && !control->charge()) {
+      relations.remove(nodes[r].row);
+      uncover(column);
+      return false;
+    }
+    CSP_STATS_ADD(stats, nodes, 1);
+    solution[level] = nodes[r].row;
+    for (int j = nodes[r].right; j != r; j = nodes[j].right) {
+      cover(nodes[j].column);
+    }
+    const bool go_on = search(level + 1, visitor);
+    for (int j = nodes[r].left; j != r; j = nodes[j].left) {
+      uncover(nodes[j].column);
+    }
+    relations.remove(nodes[r].row);
+    if (!go_on) {
+      uncover(column);
+      return false;
+    }
+    branch_done(level);
+  }
+  uncover(column);
+  return true;
+}
+
+/*!
+  \brief Counts a finished branch near the root and reports the fraction of
+         the tree explored, taking each branch as the same size
+*/
+void ExactCover::branch_done(int level) {
+  if (!control || !from_root || level >= PROGRESS_LEVELS) {
+    return;
+  }
+  ++branches_done[level];
+  double fraction = 0;
+  double width = 1;
+  for (int l = 0; l <= level; ++l) {
+    fraction += width*branches_done[l]/branches_total[l];
+    width /= branches_total[l];
+  }
+  control->set_fraction(fraction);
+}
+
+void ExactCover::branch(int level, int depth,
+                        std::vector<FactCombo> &prefixes) {
+  if (level == depth || nodes[0].right == 0) {
+    prefixes.push_back(FactCombo(solution.begin(), solution.begin() + level));
+    return;
+  }
+
+  const int column = choose_column();
+  if (column_size[column] == 0) {
+    return;
+  }
+
+  cover(column);
+  for (int r = nodes[column].down; r != column; r = nodes[r].down) {
+    if (control && !control->poll()) {
+      break;
+    }
+    if (!relations.place(nodes[r].row)) {
+      continue;
+    }
+    solution[level] = nodes[r].row;
+    for (int j = nodes[r].right; j != r; j = nodes[j].right) {
+      cover(nodes[j].column);
+    }
+    branch(level + 1, depth, prefixes);
+    for (int j = nodes[r].left; j != r; j = nodes[j].left) {
+      uncover(nodes[j].column);
+    }
+    relations.remove(nodes[r].row);
+  }
+  uncover(column);
+}
@@ -0,0 +1,78 @@
+#ifndef EXACT_COVER_H
+#define EXACT_COVER_H
+
+#include <vector>
+#include "csp_types.h"
+#include "relations.h"
+#include "search_control.h"
+#include "solver_stats.h"
+
+/*!
+  \brief Finds combinations of factoids with Algorithm X / Dancing Links
+
+  Each (property, value) pair is a column and each factoid is a row covering
+  one column per property. A unique combo is then an exact cover of all
+  columns. The column with the fewest remaining rows is branched on first,
+  so a clash is detected as soon as a column runs empty. Positional clues are
+  checked as soon as the rows holding both of their items are chosen.
+*/
+class ExactCover {
+
+public:
+
+  ExactCover(int num_values, int num_properties,
+             const PossibilityList &possibilities,
+             const std::vector<PositionalClue> &clues);
+  void solve(ComboList &combo_list);
+  bool solve(const ComboVisitor &visitor);
+  void split(int depth, std::vector<FactCombo> &prefixes);
+  bool solve(const FactCombo &prefix, const ComboVisitor &visitor);
+  const SolverStats &get_stats() const { return stats; }
+  void set_control(SearchControl *control) { this->control = control; }
+
+private:
+
+  struct Node {
+    int left;
+    int right;
+    int up;
+    int down;
+    int column;
+    int row;
+  };
+
+  int NUM_VALUES;
+  int NUM_PROPERTIES;
+
+  // Node 0 is the root, nodes 1..P*N the column headers
+  std::vector<Node> nodes;
+  std::vector<int> column_size;
+  std::vector<int> row_node;
+  FactCombo solution;
+  FactCombo combo;
+  RelationTracker relations;
+
+  // Nodes, combos and dead ends of the searches so far
+  SolverStats stats;
+
+  // Budget of the search, or nullptr
+  SearchControl *control;
+
+  // Branches done and to do at the levels near the root, for the fraction
+  // of the tree explored, only kept by a search from the root
+  static const int PROGRESS_LEVELS = 3;
+  bool from_root;
+  std::vector<int> branches_done;
+  std::vector<int> branches_total;
+
+  void cover(int column);
+  void uncover(int column);
+  void select(int row);
+  void deselect(int row);
+  int choose_column() const;
+  bool search(int level, const ComboVisitor &visitor);
+  void branch_done(int level);
+  void branch(int level, int depth, std::vector<FactCombo> &prefixes);
+};
+
+#endif
@@ -0,0 +1,21 @@
+#include "factoid_masks.h"
+
+/*!
+  \brief Encodes each factoid as a mask of its (property, value) pairs
+
+  \param num_values Number of values that each property can take
+  \param num_properties Number of properties of each factoid
+  \param possibilities The factoids to encode
+*/
+FactoidMasks::FactoidMasks(int num_values, int num_properties,
+                           const PossibilityList &possibilities) {
+  num_words = (num_values*num_properties + 63)/64;
+  bits.resize(possibilities.size()*num_words, 0);
+  for (std::size_t row = 0; row < possibilities.size(); ++row) {
+    uint64_t *mask = &bits[row*num_words];
+    for (int property = 0; property < num_properties; ++property) {
+      const int bit = property*num_values + possibilities[row][property];
+      mask[bit/64] |= uint64_t(1) << (bit % 64);
+    }
+  }
+}
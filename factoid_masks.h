@@ -0,0 +1,83 @@
+#ifndef FACTOID_MASKS_H
+#define FACTOID_MASKS_H
+
+#include <cstdint>
+#include <vector>
+#include "csp_types.h"
+
+/*!
+  \brief The (property, value) pairs of each factoid as a bitmask
+
+  Bit property*num_values + value is set in the mask of a factoid that has
+  that value. Two factoids can be in the same combo if their masks don't
+  overlap, so a combo can be checked with one AND per factoid as it is put
+  together. A mask takes one word when the grid has at most 64 pairs.
+*/
+class FactoidMasks {
+
+public:
+
+  FactoidMasks(int num_values, int num_properties,
+               const PossibilityList &possibilities);
+
+  int width() const { return num_words; }
+  const uint64_t *operator[](int row) const { return &bits[row*num_words]; }
+
+private:
+
+  int num_words;
+  std::vector<uint64_t> bits;
+};
+
+/*!
+  \brief The pairs used by a partial combo, for grids of at most 64 pairs
+*/
+class NarrowMask {
+
+public:
+
+  explicit NarrowMask(int) : used(0) {}
+
+  bool fits(const uint64_t *mask) const { return !(used & *mask); }
+  void add(const uint64_t *mask) { used |= *mask; }
+  void remove(const uint64_t *mask) { used &= ~*mask; }
+
+private:
+
+  uint64_t used;
+};
+
+/*!
+  \brief The pairs used by a partial combo, for larger grids
+*/
+class WideMask {
+
+public:
+
+  explicit WideMask(int width) : used(width, 0) {}
+
+  bool fits(const uint64_t *mask) const {
+    for (std::size_t w = 0; w < used.size(); ++w) {
+      if (used[w] & mask[w]) {
+        return false;
+      }
+    }
+    return true;
+  }
+  void add(const uint64_t *mask) {
+    for (std::size_t w = 0; w < used.size(); ++w) {
+      used[w] |= mask[w];
+    }
+  }
+  void remove(const uint64_t *mask) {
+    for (std::size_t w = 0; w < used.size(); ++w) {
+      used[w] &= ~mask[w];
+    }
+  }
+
+private:
+
+  std::vector<uint64_t> used;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef FIXED_TRUTH_TABLE_H
+#define FIXED_TRUTH_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "truth_table.h"
+
+/*!
+  \brief Dense truth table with the dimensions fixed at compile time
+
+  The words and the clue operations are those of TruthTable. The strides are
+  constants, so the compiler unrolls the index arithmetic and turns the
+  divisions that decode a cell into multiplications. The possibilities are
+  found by walking the set bits of the cells in range, jumping over the
+  words and chunks without a true cell with the summary bits of TruthTable.
+*/
+template <int N, int P>
+class FixedTruthTable : public TruthTable {
+
+  static_assert(N > 0 && P > 0, "A puzzle needs values and properties");
+
+public:
+
+  FixedTruthTable() : TruthTable(N, P) {}
+
+  bool test(const Factoid &factoid) const {
+    return test_cell(cell(factoid, P));
+  }
+
+  bool visit_possibilities(int level, Factoid &factoid,
+                           const FactoidVisitor &visitor) const {
+    // The leading properties fix a run of cells
+    const std::size_t first = cell(factoid, level);
+    const std::size_t last = first + (level ? STRIDES[level - 1] : NUM_CELLS);
+
+    const std::size_t end_word = (last + 63)/64;
+    for (std::size_t w = first/64; w < end_word; ++w) {
+      // Jump over the chunks and the words without a true cell
+      if (w % (64*64) == 0 && !live_chunk(w/(64*64))) {
+        w = next_chunk(w/(64*64))*64*64 - 1;
+        continue;
+      }
+      const uint64_t live = summary[w/64] >> (w % 64);
+      if (interrupted()) {
+        return false;
+      }
+      if (!live) {
+        w |= 63;
+        continue;
+      }
+      w += __builtin_ctzll(live);
+      if (w >= end_word) {
+        break;
+      }
+      uint64_t bits = words[w];
+      if (w == first/64) {
+        bits &= ~uint64_t(0) << (first % 64);
+      }
+      if ((w + 1)*64 > last) {
+        bits &= ~uint64_t(0) >> (64 - last % 64);
+      }
+      while (bits) {
+        const std::size_t index = w*64 + __builtin_ctzll(bits);
+        bits &= bits - 1;
+        CSP_STATS_ADD(stats, cells_visited, 1);
+        for (int i = level; i < P; ++i) {
+          factoid[i] = (index/STRIDES[i]) % N;
+        }
+        if (!visitor(factoid)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+
+  static constexpr std::array<std::size_t, P> make_strides() {
+    std::array<std::size_t, P> strides{};
+    std::size_t stride = 1;
+    for (int i = P - 1; i >= 0; --i) {
+      strides[i] = stride;
+      stride *= N;
+    }
+    return strides;
+  }
+
+  // Whether N^P cells and their words can be counted in a std::size_t, as
+  // TruthTable::fits() checks at run time
+  static constexpr bool cells_fit() {
+    std::size_t cells = 1;
+    for (int i = 0; i < P; ++i) {
+      if (cells > std::numeric_limits<std::size_t>::max()/N) {
+        return false;
+      }
+      cells *= N;
+    }
+    return cells <= std::numeric_limits<std::size_t>::max() - 63;
+  }
+
+  static_assert(cells_fit(), "N^P cells overflow std::size_t");
+
+  static constexpr std::array<std::size_t, P> STRIDES = make_strides();
+  static constexpr std::size_t NUM_CELLS = STRIDES[0]*N;
+
+  static std::size_t cell(const Factoid &factoid, int level) {
+    std::size_t index = 0;
+    for (int i = 0; i < level; ++i) {
+      index += STRIDES[i]*factoid[i];
+    }
+    return index;
+  }
+};
+
+#endif
@@ -50,6 +50,11 @@ int main(int argc, char* argv[])
     // 5. The person with the Dogs [sic] lives directly to the right
     //    of the Green [sic] house.
     solver.disconnect(dogs, green);
+    solver.relate(green, dogs, NUMBER, OFFSET, 1);
+
+    // 4. The person with the Fishes [sic!] lives directly to the left
+    //    of the person with the Cats [sic].
+    solver.relate(fish, cats, NUMBER, OFFSET, 1);
 
     // 6. The German lives in house three.
     solver.connect(German, three);
@@ -73,6 +78,7 @@ int main(int argc, char* argv[])
         << std::endl;
 
     // Now we need to test so we don't put the same pet in two houses etc.
+    // The positional clues are checked while the combinations are built.
     ComboList combo_list;
     solver.get_unique_combos(combo_list, possibilities);
 
@@ -82,40 +88,18 @@ int main(int argc, char* argv[])
     std::cout << "After removing combinations that are impossible, " << std::endl
 	      << "there are " << combo_list.size() << " combinations "
       "remaining. " << std::endl; //
-    for (auto combo : combo_list) {
-    	for (int house = 0; house < NUM_HOUSES; ++house) {
-    		for (int i = 0; i < NUM_CATEGORIES; ++i) {
-    			std::cout << solver.get_name(i, possibilities[combo[house]][i]) << " ";
-    		}
-    	}
-    	std::cout << std::endl;
-    }
-
-    std::cout << "Now we need to check the final clue." << std::endl;
     std::cout << "--------------------------------------------------"
         << std::endl;
 
-    // Check which combo is consistent with relational clues
-
-    // 4. The person with the Fishes [sic!] lives directly to the left
-    //    of the person with the Cats [sic].
-    // 5. The person with the Dogs [sic] lives directly to the right
-     //    of the Green [sic] house.
-
     for (auto combo : combo_list) {
-    	if (solver.get_property(fish, NUMBER, combo, possibilities) ==
-    			solver.get_property(cats, NUMBER, combo, possibilities) - 1 and
-				solver.get_property(dogs, NUMBER, combo, possibilities) - 1 ==
-				solver.get_property(green, NUMBER, combo, possibilities)) {
-    		for (int row = 0; row < NUM_HOUSES; ++row ) {
-    			for (int property = 0; property < NUM_CATEGORIES; ++property) {
-    				std::cout << solver.get_name(property, possibilities[combo[ row ]][property]) << " ";
-    			}
-    			std::cout << std::endl;
+    	for (int row = 0; row < NUM_HOUSES; ++row ) {
+    		for (int property = 0; property < NUM_CATEGORIES; ++property) {
+    			std::cout << solver.get_name(property, possibilities[combo[ row ]][property]) << " ";
     		}
-    		std::cout << "--------------------------------------------------"
-    				<< std::endl;
+    		std::cout << std::endl;
     	}
+    	std::cout << "--------------------------------------------------"
+    			<< std::endl;
     }
 
     return 0;
@@ -0,0 +1,163 @@
+#include "live_lists.h"
+
+/*!
+  \brief Lists the possibilities of the clues given so far
+
+  \param solver The solver that the clues go to, must outlive the lists
+*/
+LiveLists::LiveLists(CspSolver &solver)
+  : solver(solver), combos_found(false) {
+  refresh();
+}
+
+/*!
+  \brief Connects two fact items and drops what they rule out
+
+  \param[in] fact1 A pointer to FactItem 1
+  \param[in] fact2 A pointer to FactItem 2
+*/
+void LiveLists::connect(FactItem *fact1, FactItem *fact2) {
+  solver.connect(fact1, fact2);
+  drop_impossible(fact1->type, fact1->value, fact2->type, fact2->value);
+}
+
+/*!
+  \brief Disconnects two fact items and drops what they rule out
+
+  \param[in] fact1 A pointer to FactItem 1
+  \param[in] fact2 A pointer to FactItem 2
+*/
+void LiveLists::disconnect(FactItem *fact1, FactItem *fact2) {
+  solver.disconnect(fact1, fact2);
+  drop_impossible(fact1->type, fact1->value, fact2->type, fact2->value);
+}
+
+/*!
+  \brief Adds a positional clue and drops the combos that break it
+
+  \param[in] fact1 A pointer to FactItem 1
+  \param[in] fact2 A pointer to FactItem 2
+  \param[in] property The ordinal property, e.g. the house number
+  \param[in] relation How the ordinals of the two fact items compare
+  \param[in] distance The offset or distance, if the relation needs one
+*/
+void LiveLists::relate(FactItem *fact1, FactItem *fact2, int property,
+                       Relation relation, int distance) {
+  solver.relate(fact1, fact2, property, relation, distance);
+  if (!combos_found) {
+    return;
+  }
+  PositionalClue clue;
+  clue.type1 = fact1->type;
+  clue.value1 = fact1->value;
+  clue.type2 = fact2->type;
+  clue.value2 = fact2->value;
+  clue.property = property;
+  clue.relation = relation;
+  clue.distance = distance;
+  const RelationFilter filter({clue}, possibility_list);
+  ComboList survivors(combo_list.width());
+  filter.filter(combo_list, survivors);
+  combo_list = std::move(survivors);
+}
+
+/*!
+  \brief Drops what the solver has ruled out since the lists were made,
+         e.g. by clues given to it directly or by propagate()
+
+  Every possibility is tested, but nothing is searched again. Positional
+  clues given to the solver directly aren't seen.
+*/
+void LiveLists::update() {
+  drop_impossible(-1, 0, -1, 0);
+}
+
+/*!
+  \brief Lists the possibilities again and forgets the combos, e.g. after a
+         rollback() of the solver
+*/
+void LiveLists::refresh() {
+  possibility_list.clear();
+  combo_list.clear();
+  combos_found = false;
+  Factoid factoid(solver.num_properties());
+  solver.get_possibilities(0, factoid, possibility_list);
+}
+
+/*!
+  \brief Searches for the combos of the possibilities, to keep them from
+         now on
+
+  \param limit Give up if there are more combos than this, 0 finds all
+  \return false if there were too many, has_combos() tells the same
+*/
+bool LiveLists::find_combos(std::size_t limit) {
+  combo_list.clear();
+  bool too_many = false;
+  solver.for_each_combo(possibility_list,
+                        [this, limit, &too_many](const FactCombo &combo) {
+                          if (limit && combo_list.size() == limit) {
+                            too_many = true;
+                            return false;
+                          }
+                          combo_list.push_back(combo);
+                          return true;
+                        });
+  if (too_many) {
+    combo_list.clear();
+  }
+  combos_found = !too_many;
+  return combos_found;
+}
+
+// Private methods ----------------------------------------------
+
+/*!
+  \brief Drops the possibilities that the solver rules out and the combos
+         that use them
+
+  Only the factoids that hold value1 of property1 or value2 of property2
+  are tested, all of them if property1 is negative.
+*/
+void LiveLists::drop_impossible(int property1, int value1,
+                                int property2, int value2) {
+  const int num_properties = solver.num_properties();
+  Factoid factoid(num_properties);
+
+  // The new index of each possibility, -1 if it went
+  std::vector<int> renumbered(possibility_list.size());
+  PossibilityList kept(num_properties);
+  for (std::size_t row = 0; row < possibility_list.size(); ++row) {
+    const FactoidView view = possibility_list[row];
+    if (property1 < 0 || view[property1] == value1 ||
+        view[property2] == value2) {
+      factoid.assign(view.begin(), view.end());
+      if (!solver.is_possible(factoid)) {
+        renumbered[row] = -1;
+        continue;
+      }
+    }
+    renumbered[row] = kept.size();
+    kept.push_back(view);
+  }
+  if (kept.size() == possibility_list.size()) {
+    return;
+  }
+
+  if (combos_found) {
+    ComboList survivors(combo_list.width());
+    FactCombo combo(combo_list.width());
+    for (const ComboView old : combo_list) {
+      bool alive = true;
+      for (int i = 0; alive && i < old.size(); ++i) {
+        combo[i] = renumbered[old[i]];
+        alive = (combo[i] >= 0);
+      }
+      if (alive) {
+        survivors.push_back(combo);
+      }
+    }
+    combo_list = std::move(survivors);
+  }
+  possibility_list = std::move(kept);
+}
@@ -0,0 +1,53 @@
+#ifndef LIVE_LISTS_H
+#define LIVE_LISTS_H
+
+#include <cstddef>
+#include <vector>
+#include "csp_solver.h"
+
+/*!
+  \brief The possibilities and combos of a solver, kept up to date as clues
+         are added one at a time
+
+  A clue given through connect() or disconnect() can only rule out the
+  factoids that hold one of its items, so only those are tested against the
+  solver. The ones that went are dropped from the possibilities and every
+  combo that used one of them is dropped too. The remaining combos are
+  renumbered, nothing is searched again. A clue given through relate()
+  leaves the possibilities alone and filters the combos, see
+  RelationFilter.
+
+  The combos are only searched for when asked, and may be given up on when
+  there are too many, as there are before most clues are known. Clues given
+  to the solver directly, propagate() and rollback() aren't seen, update()
+  catches up with the first two and refresh() starts over.
+*/
+class LiveLists {
+
+public:
+
+  explicit LiveLists(CspSolver &solver);
+
+  void connect(FactItem *fact1, FactItem *fact2);
+  void disconnect(FactItem *fact1, FactItem *fact2);
+  void relate(FactItem *fact1, FactItem *fact2, int property,
+              Relation relation, int distance = 0);
+  void update();
+  void refresh();
+
+  bool find_combos(std::size_t limit = 0);
+  bool has_combos() const { return combos_found; }
+  const PossibilityList &possibilities() const { return possibility_list; }
+  const ComboList &combos() const { return combo_list; }
+
+private:
+
+  CspSolver &solver;
+  PossibilityList possibility_list;
+  ComboList combo_list;
+  bool combos_found;
+
+  void drop_impossible(int property1, int value1, int property2, int value2);
+};
+
+#endif
@@ -0,0 +1,28 @@
+#include <memory>
+#include "mapped_truth_table.h"
+
+/*!
+  \brief Constructs a truth table where all cells are true, in a new file
+
+  \param num_values Number of values that each property can take
+  \param num_properties Number of properties, i.e. dimensions of the table
+  \param path The scratch file, on a disk with room for N^P/8 bytes
+*/
+MappedTruthTable::MappedTruthTable(int num_values, int num_properties,
+                                   const std::string &path)
+  : TruthTable(num_values, num_properties, false) {
+  if (!fits(num_values, num_properties)) {
+    message = std::to_string(num_values) + "^" +
+      std::to_string(num_properties) + " cells are too many to index";
+    return;
+  }
+  const std::size_t num_words = (num_cells + 63)/64;
+  std::shared_ptr<WordRegion> region =
+    std::make_shared<WordRegion>(path, num_words*sizeof(uint64_t));
+  if (!region->is_open()) {
+    message = region->error();
+    return;
+  }
+  words = WordVector(WordAllocator<uint64_t>(region));
+  fill();
+}
@@ -0,0 +1,36 @@
+#ifndef MAPPED_TRUTH_TABLE_H
+#define MAPPED_TRUTH_TABLE_H
+
+#include <string>
+#include "truth_table.h"
+
+/*!
+  \brief Dense truth table whose words live in a scratch file mapped into
+         memory, for grids too large for RAM
+
+  The cells, the clues and the snapshots are those of TruthTable, only the
+  words are paged in and out of the file by the kernel. The clues sweep the
+  file in order and skip the chunks that are all false, and so do the
+  possibilities, so a table mostly ruled out stays cheap however large it
+  is. The summary and chunk bits stay in memory, 1/64 of the file.
+
+  The file must not exist. It is removed as soon as it is mapped, so it
+  takes disk space only while the table lives. The table can't be used
+  unless is_open().
+*/
+class MappedTruthTable : public TruthTable {
+
+public:
+
+  MappedTruthTable(int num_values, int num_properties,
+                   const std::string &path);
+
+  bool is_open() const { return !words.empty(); }
+  const std::string &error() const { return message; }
+
+private:
+
+  std::string message;
+};
+
+#endif
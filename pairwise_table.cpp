@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <utility>
+#include "pairwise_table.h"
+
+namespace {
+
+const int WORD_BITS = 64;
+
+/*!
+  \brief Tries to find an augmenting path from a value of the first property
+*/
+bool augment(int x, const std::vector<std::vector<int>> &edges,
+             std::vector<bool> &visited, std::vector<int> &match_x,
+             std::vector<int> &match_y) {
+  for (int y : edges[x]) {
+    if (!visited[y]) {
+      visited[y] = true;
+      if (match_y[y] < 0 ||
+          augment(match_y[y], edges, visited, match_x, match_y)) {
+        match_x[x] = y;
+        match_y[y] = x;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/*!
+  \brief Tarjan's algorithm for the strongly connected components
+*/
+void strong_connect(int node, const std::vector<std::vector<int>> &graph,
+                    int &counter, std::vector<int> &index,
+                    std::vector<int> &low, std::vector<int> &stack,
+                    std::vector<bool> &on_stack, std::vector<int> &component) {
+  index[node] = low[node] = counter++;
+  stack.push_back(node);
+  on_stack[node] = true;
+  for (int next : graph[node]) {
+    if (index[next] < 0) {
+      strong_connect(next, graph, counter, index, low, stack, on_stack,
+                     component);
+      low[node] = std::min(low[node], low[next]);
+    }
+    else if (on_stack[next]) {
+      low[node] = std::min(low[node], index[next]);
+    }
+  }
+  if (low[node] == index[node]) {
+    int member;
+    do {
+      member = stack.back();
+      stack.pop_back();
+      on_stack[member] = false;
+      component[member] = node;
+    } while (member != node);
+  }
+}
+
+}
+
+/*!
+  \brief Constructs pairwise matrices where all combinations are allowed
+
+  \param num_values Number of values that each property can take
+  \param num_properties Number of properties
+*/
+PairwiseTable::PairwiseTable(int num_values, int num_properties) {
+  NUM_VALUES = num_values;
+  NUM_PROPERTIES = num_properties;
+  ROW_WORDS = (NUM_VALUES + WORD_BITS - 1)/WORD_BITS;
+
+  const std::size_t num_pairs = NUM_PROPERTIES*(NUM_PROPERTIES - 1)/2;
+  matrices.resize(num_pairs*NUM_VALUES*ROW_WORDS, 0);
+  for (std::size_t r = 0; r < num_pairs*NUM_VALUES; ++r) {
+    for (int value = 0; value < NUM_VALUES; ++value) {
+      matrices[r*ROW_WORDS + value/WORD_BITS] |=
+        uint64_t(1) << (value % WORD_BITS);
+    }
+  }
+}
+
+/*!
+  \brief Only allows value1 together with value2 and vice versa
+*/
+void PairwiseTable::connect(int property1, int value1,
+                            int property2, int value2) {
+  if (property1 > property2) {
+    std::swap(property1, property2);
+    std::swap(value1, value2);
+  }
+  for (int value = 0; value < NUM_VALUES; ++value) {
+    const std::size_t cells = row(property1, value, property2);
+    if (value == value1) {
+      for (int w = 0; w < ROW_WORDS; ++w) {
+        const uint64_t kept = (w == value2/WORD_BITS) ?
+          uint64_t(1) << (value2 % WORD_BITS) : 0;
+        clear_bits(matrices, cells + w, ~kept);
+      }
+    }
+    else {
+      clear_bits(matrices, cells + value2/WORD_BITS,
+                 uint64_t(1) << (value2 % WORD_BITS));
+    }
+  }
+}
+
+/*!
+  \brief Forbids value1 together with value2
+*/
+void PairwiseTable::disconnect(int property1, int value1,
+                               int property2, int value2) {
+  if (property1 > property2) {
+    std::swap(property1, property2);
+    std::swap(value1, value2);
+  }
+  clear_bits(matrices, row(property1, value1, property2) + value2/WORD_BITS,
+             uint64_t(1) << (value2 % WORD_BITS));
+}
+
+/*!
+  \brief Checks whether a pair of values is still compatible
+*/
+bool PairwiseTable::allowed(int property1, int value1,
+                            int property2, int value2) const {
+  return allowed(matrices, property1, value1, property2, value2);
+}
+
+/*!
+  \brief Checks whether a pair of values was compatible in matrices saved
+         from state() of this table
+*/
+bool PairwiseTable::allowed(const WordVector &words, int property1,
+                            int value1, int property2, int value2) const {
+  if (property1 > property2) {
+    std::swap(property1, property2);
+    std::swap(value1, value2);
+  }
+  return (words[row(property1, value1, property2) + value2/WORD_BITS] >>
+          (value2 % WORD_BITS)) & 1;
+}
+
+/*!
+  \brief Allows value1 together with value2 again
+*/
+void PairwiseTable::allow(int property1, int value1,
+                          int property2, int value2) {
+  if (property1 > property2) {
+    std::swap(property1, property2);
+    std::swap(value1, value2);
+  }
+  matrices[row(property1, value1, property2) + value2/WORD_BITS] |=
+    uint64_t(1) << (value2 % WORD_BITS);
+}
+
+/*!
+  \brief Forbids all pairs of values
+*/
+void PairwiseTable::clear() {
+  std::fill(matrices.begin(), matrices.end(), 0);
+}
+
+/*!
+  \brief Copies the matrices, which already are the pairwise projection
+
+  Only the state is copied, not the checkpoints or the control.
+*/
+void PairwiseTable::project(PairwiseTable &support) const {
+  support.matrices = matrices;
+}
+
+/*!
+  \brief Removes the pairs of values that no third property can support
+
+  A pair (x, y) of properties i and j needs, for every other property k, a
+  value z that is compatible with both x and y (path consistency).
+
+  \return true if any pair was removed
+*/
+bool PairwiseTable::revise_paths() {
+  bool removed = false;
+  std::vector<uint64_t> masks_x(NUM_PROPERTIES*ROW_WORDS);
+  std::vector<uint64_t> masks_y(NUM_PROPERTIES*ROW_WORDS);
+
+  for (int i = 0; i < NUM_PROPERTIES; ++i) {
+    for (int j = i + 1; j < NUM_PROPERTIES; ++j) {
+      for (int x = 0; x < NUM_VALUES; ++x) {
+        for (int k = 0; k < NUM_PROPERTIES; ++k) {
+          if (k != i && k != j) {
+            compatible(i, x, k, &masks_x[k*ROW_WORDS]);
+          }
+        }
+        for (int y = 0; y < NUM_VALUES; ++y) {
+          if (!allowed(i, x, j, y)) {
+            continue;
+          }
+          bool supported = true;
+          for (int k = 0; supported && k < NUM_PROPERTIES; ++k) {
+            if (k == i || k == j) {
+              continue;
+            }
+            compatible(j, y, k, &masks_y[k*ROW_WORDS]);
+            uint64_t common = 0;
+            for (int w = 0; w < ROW_WORDS; ++w) {
+              common |= masks_x[k*ROW_WORDS + w] & masks_y[k*ROW_WORDS + w];
+            }
+            supported = (common != 0);
+          }
+          if (!supported) {
+            disconnect(i, x, j, y);
+            removed = true;
+          }
+        }
+      }
+    }
+  }
+  return removed;
+}
+
+/*!
+  \brief Removes the pairs of values that can't be part of any solution
+         since each value is used exactly once
+
+  For every pair of properties the values must be matched one to one. A pair
+  of values that isn't part of any perfect matching is removed, which covers
+  both forced singletons and Hall sets (Regin's all-different filtering).
+
+  \return false if some pair of properties has no perfect matching, i.e.
+          the clues contradict each other
+*/
+bool PairwiseTable::all_different() {
+  for (int i = 0; i < NUM_PROPERTIES; ++i) {
+    for (int j = i + 1; j < NUM_PROPERTIES; ++j) {
+      if (!all_different(i, j)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*!
+  \brief Checks whether all pairs of values in a factoid are compatible
+*/
+bool PairwiseTable::test(const Factoid &factoid) const {
+  for (int i = 0; i < NUM_PROPERTIES; ++i) {
+    for (int j = i + 1; j < NUM_PROPERTIES; ++j) {
+      if (!allowed(i, factoid[i], j, factoid[j])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*!
+  \brief Visits the factoids that are still possible
+
+  The factoids come out in the same order as from the dense table.
+
+  \param[in] level Number of leading properties already fixed in factoid
+  \param[in,out] factoid Work space with one entry per property
+  \param[in] visitor Called with each factoid compatible with all matrices
+  \return false if the visitor or the control stopped the enumeration
+*/
+bool PairwiseTable::visit_possibilities(int level, Factoid &factoid,
+                                        const FactoidVisitor &visitor) const {
+  for (int j = 0; j < level; ++j) {
+    for (int i = 0; i < j; ++i) {
+      if (!allowed(i, factoid[i], j, factoid[j])) {
+        return true;
+      }
+    }
+  }
+
+  // One set of remaining domains per level of the join
+  std::vector<uint64_t> domains((NUM_PROPERTIES + 1)*NUM_PROPERTIES*ROW_WORDS,
+                                0);
+  uint64_t *domain = &domains[level*NUM_PROPERTIES*ROW_WORDS];
+  for (int property = level; property < NUM_PROPERTIES; ++property) {
+    uint64_t *cells = &domain[property*ROW_WORDS];
+    for (int value = 0; value < NUM_VALUES; ++value) {
+      cells[value/WORD_BITS] |= uint64_t(1) << (value % WORD_BITS);
+    }
+    for (int j = 0; j < level; ++j) {
+      const uint64_t *compatible = &matrices[row(j, factoid[j], property)];
+      for (int w = 0; w < ROW_WORDS; ++w) {
+        cells[w] &= compatible[w];
+      }
+    }
+  }
+  return join(level, factoid, domains, visitor);
+}
+
+// Private methods ----------------------------------------------
+
+std::size_t PairwiseTable::row(int property1, int value1,
+                               int property2) const {
+  const std::size_t pair = property1*(2*NUM_PROPERTIES - property1 - 1)/2 +
+    (property2 - property1 - 1);
+  return (pair*NUM_VALUES + value1)*ROW_WORDS;
+}
+
+void PairwiseTable::compatible(int property1, int value1, int property2,
+                               uint64_t *mask) const {
+  if (property1 < property2) {
+    const uint64_t *cells = &matrices[row(property1, value1, property2)];
+    std::copy(cells, cells + ROW_WORDS, mask);
+    return;
+  }
+  std::fill(mask, mask + ROW_WORDS, 0);
+  for (int value = 0; value < NUM_VALUES; ++value) {
+    if (allowed(property2, value, property1, value1)) {
+      mask[value/WORD_BITS] |= uint64_t(1) << (value % WORD_BITS);
+    }
+  }
+}
+
+bool PairwiseTable::all_different(int property1, int property2) {
+  std::vector<std::vector<int>> edges(NUM_VALUES);
+  for (int x = 0; x < NUM_VALUES; ++x) {
+    for (int y = 0; y < NUM_VALUES; ++y) {
+      if (allowed(property1, x, property2, y)) {
+        edges[x].push_back(y);
+      }
+    }
+  }
+
+  std::vector<int> match_x(NUM_VALUES, -1);
+  std::vector<int> match_y(NUM_VALUES, -1);
+  for (int x = 0; x < NUM_VALUES; ++x) {
+    std::vector<bool> visited(NUM_VALUES, false);
+    if (!augment(x, edges, visited, match_x, match_y)) {
+      return false;
+    }
+  }
+
+  // Unmatched edges point from x to y and matched ones back from y to x, so
+  // an edge is in some perfect matching iff it lies on an alternating cycle.
+  std::vector<std::vector<int>> graph(2*NUM_VALUES);
+  for (int x = 0; x < NUM_VALUES; ++x) {
+    for (int y : edges[x]) {
+      if (match_x[x] == y) {
+        graph[NUM_VALUES + y].push_back(x);
+      }
+      else {
+        graph[x].push_back(NUM_VALUES + y);
+      }
+    }
+  }
+  int counter = 0;
+  std::vector<int> index(2*NUM_VALUES, -1);
+  std::vector<int> low(2*NUM_VALUES, 0);
+  std::vector<int> stack;
+  std::vector<bool> on_stack(2*NUM_VALUES, false);
+  std::vector<int> component(2*NUM_VALUES, -1);
+  for (int node = 0; node < 2*NUM_VALUES; ++node) {
+    if (index[node] < 0) {
+      strong_connect(node, graph, counter, index, low, stack, on_stack,
+                     component);
+    }
+  }
+
+  for (int x = 0; x < NUM_VALUES; ++x) {
+    for (int y : edges[x]) {
+      if (match_x[x] != y && component[x] != component[NUM_VALUES + y]) {
+        disconnect(property1, x, property2, y);
+      }
+    }
+  }
+  return true;
+}
+
+bool PairwiseTable::join(int level, Factoid &factoid,
+                         std::vector<uint64_t> &domains,
+                         const FactoidVisitor &visitor) const {
+  if (level == NUM_PROPERTIES) {
+    return visitor(factoid);
+  }
+  if (interrupted()) {
+    return false;
+  }
+
+  const std::size_t level_size = NUM_PROPERTIES*ROW_WORDS;
+  const uint64_t *domain = &domains[level*level_size];
+  uint64_t *next = &domains[(level + 1)*level_size];
+
+  for (int w = 0; w < ROW_WORDS; ++w) {
+    uint64_t candidates = domain[level*ROW_WORDS + w];
+    while (candidates) {
+      const int value = w*WORD_BITS + __builtin_ctzll(candidates);
+      candidates &= candidates - 1;
+      factoid[level] = value;
+      CSP_STATS_ADD(stats, cells_visited, 1);
+
+      // Forward check the properties that are still to be assigned
+      bool consistent = true;
+      for (int property = level + 1; consistent && property < NUM_PROPERTIES;
+           ++property) {
+        const uint64_t *compatible = &matrices[row(level, value, property)];
+        uint64_t any = 0;
+        for (int v = 0; v < ROW_WORDS; ++v) {
+          next[property*ROW_WORDS + v] =
+            domain[property*ROW_WORDS + v] & compatible[v];
+          any |= next[property*ROW_WORDS + v];
+        }
+        consistent = (any != 0);
+      }
+      if (consistent && !join(level + 1, factoid, domains, visitor)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,61 @@
+#ifndef PAIRWISE_TABLE_H
+#define PAIRWISE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "domain_store.h"
+
+/*!
+  \brief Truth table factored into one compatibility matrix per property pair
+
+  Every clue only involves two properties, so the dense table is exactly the
+  join of these N x N matrices. Memory grows as P^2*N^2 instead of N^P, and
+  the possibilities are produced by a join with forward checking.
+*/
+class PairwiseTable : public DomainStore {
+
+public:
+
+  PairwiseTable(int num_values, int num_properties);
+
+  void connect(int property1, int value1, int property2, int value2);
+  void disconnect(int property1, int value1, int property2, int value2);
+  bool test(const Factoid &factoid) const;
+  bool visit_possibilities(int level, Factoid &factoid,
+                           const FactoidVisitor &visitor) const;
+  void project(PairwiseTable &support) const;
+  TableType table_type() const { return PAIRWISE_TABLE; }
+
+  bool allowed(int property1, int value1, int property2, int value2) const;
+  bool allowed(const WordVector &words, int property1, int value1,
+               int property2, int value2) const;
+  void allow(int property1, int value1, int property2, int value2);
+  void clear();
+  bool revise_paths();
+  bool all_different();
+
+protected:
+
+  WordVector &bits() { return matrices; }
+  const WordVector &bits() const { return matrices; }
+
+private:
+
+  int NUM_VALUES;
+  int NUM_PROPERTIES;
+  int ROW_WORDS;
+
+  // Row 'value1' of the matrix for (property1 < property2) holds the values
+  // of property2 that are still compatible with it.
+  WordVector matrices;
+
+  std::size_t row(int property1, int value1, int property2) const;
+  bool join(int level, Factoid &factoid, std::vector<uint64_t> &domains,
+            const FactoidVisitor &visitor) const;
+  void compatible(int property1, int value1, int property2,
+                  uint64_t *mask) const;
+  bool all_different(int property1, int property2);
+};
+
+#endif
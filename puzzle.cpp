@@ -0,0 +1,293 @@
+#include <cstdlib>
+#include <string>
+#include "puzzle.h"
+
+/*!
+  \brief Constructs a puzzle without clues
+
+  \param num_values Number of houses, and values of each property
+  \param num_properties Number of properties, including the house number
+*/
+Puzzle::Puzzle(int num_values, int num_properties)
+  : num_values(num_values), num_properties(num_properties) {
+  solution.resize(num_properties, std::vector<int>(num_values, 0));
+}
+
+/*!
+  \brief Gets the name of a property, e.g. "colour" or "p2"
+*/
+std::string Puzzle::category_name(int property) const {
+  if (property < (int)category_names.size()) {
+    return category_names[property];
+  }
+  return "p" + std::to_string(property);
+}
+
+/*!
+  \brief Gets the name of a value of a property, e.g. "red" or "3"
+*/
+std::string Puzzle::item_name(int property, int value) const {
+  if (property < (int)item_names.size()) {
+    return item_names[property][value];
+  }
+  return std::to_string(value);
+}
+
+/*!
+  \brief Makes the fact items of the puzzle in the order of their values
+
+  \return The item of value v of property p at index p*num_values + v
+*/
+FactItems Puzzle::make_items(CspSolver &solver) const {
+  FactItems items;
+  for (int property = 0; property < num_properties; ++property) {
+    for (int value = 0; value < num_values; ++value) {
+      items.emplace_back(solver.make_fact_item(property,
+                                               item_name(property, value)));
+    }
+  }
+  return items;
+}
+
+/*!
+  \brief Gives one clue to a solver
+
+  \param[in,out] solver The solver that the items were made by
+  \param[in] items The fact items from make_items()
+  \param[in] clue The clue to apply
+*/
+void Puzzle::apply(CspSolver &solver, const FactItems &items,
+                   const Clue &clue) const {
+  FactItem *fact1 = items[clue.type1*num_values + clue.value1].get();
+  FactItem *fact2 = items[clue.type2*num_values + clue.value2].get();
+  switch (clue.type) {
+  case CONNECT:
+    solver.connect(fact1, fact2);
+    break;
+  case DISCONNECT:
+    solver.disconnect(fact1, fact2);
+    break;
+  case RELATE:
+    solver.relate(fact1, fact2, clue.property, clue.relation, clue.distance);
+    break;
+  }
+}
+
+/*!
+  \brief Gives all clues to a solver
+*/
+void Puzzle::pose(CspSolver &solver) const {
+  FactItems items = make_items(solver);
+  for (const Clue &clue : clues) {
+    apply(solver, items, clue);
+  }
+}
+
+/*!
+  \brief Constructs a generator
+
+  \param seed Seed of the random number generator
+*/
+PuzzleGenerator::PuzzleGenerator(uint32_t seed) : rng(seed) {
+}
+
+/*!
+  \brief Makes a puzzle with a unique solution
+
+  Uniqueness is checked after every num_properties clues, once the solver
+  has drawn its conclusions from them, so the puzzle may have a few clues
+  more than it needs.
+
+  \param num_values Number of houses, at least 2
+  \param num_properties Number of properties, at least 2
+  \param table_type The table used by the solver that checks the puzzle
+*/
+Puzzle PuzzleGenerator::generate(int num_values, int num_properties,
+                                 TableType table_type) {
+  Puzzle puzzle(num_values, num_properties);
+  for (int property = 0; property < num_properties; ++property) {
+    std::vector<int> &values = puzzle.solution[property];
+    for (int house = 0; house < num_values; ++house) {
+      values[house] = house;
+    }
+    // std::shuffle isn't the same on every platform
+    for (int house = num_values - 1; property > 0 && house > 0; --house) {
+      std::swap(values[house], values[random(house + 1)]);
+    }
+  }
+
+  CspSolver solver(num_values, num_properties, table_type);
+  FactItems items = puzzle.make_items(solver);
+  Factoid factoid(num_properties);
+  while (true) {
+    const Clue clue = random_clue(puzzle);
+    puzzle.clues.push_back(clue);
+    puzzle.apply(solver, items, clue);
+    if (puzzle.clues.size() % num_properties) {
+      continue;
+    }
+    solver.propagate();
+    PossibilityList possibilities;
+    solver.get_possibilities(0, factoid, possibilities);
+    // Searching a loosely constrained puzzle can take long even to find two
+    // solutions, so wait until it is down to a few factoids per house
+    if (possibilities.size() <= (std::size_t)num_values*num_values &&
+        solver.count_combos(possibilities, 2) == 1) {
+      return puzzle;
+    }
+  }
+}
+
+/*!
+  \brief Removes clues until every remaining clue is needed for the solution
+         to be unique
+
+  The clues are tried in random order. To test a clue, all the others must
+  be given, so the clues are split in halves: the kept clues of one half are
+  given under a checkpoint while the other half is tested the same way, and
+  then rolled back. One solver is used throughout and each clue is given
+  O(log n) times instead of n times.
+
+  \param[in,out] puzzle A puzzle with a unique solution
+  \param[in] table_type The table used by the solver that checks the puzzle
+*/
+void PuzzleGenerator::minimize(Puzzle &puzzle, TableType table_type) {
+  std::vector<Clue> &clues = puzzle.clues;
+  for (int i = clues.size() - 1; i > 0; --i) {
+    std::swap(clues[i], clues[random(i + 1)]);
+  }
+
+  CspSolver solver(puzzle.num_values, puzzle.num_properties, table_type);
+  FactItems items = puzzle.make_items(solver);
+  std::vector<bool> kept(clues.size(), true);
+  if (!clues.empty()) {
+    reduce(solver, puzzle, items, kept, 0, clues.size());
+  }
+
+  std::vector<Clue> needed;
+  for (std::size_t i = 0; i < clues.size(); ++i) {
+    if (kept[i]) {
+      needed.push_back(clues[i]);
+    }
+  }
+  clues.swap(needed);
+}
+
+/*!
+  \brief Makes a puzzle with a unique solution and no redundant clues
+*/
+Puzzle PuzzleGenerator::generate_minimal(int num_values, int num_properties,
+                                         TableType table_type) {
+  Puzzle puzzle = generate(num_values, num_properties, table_type);
+  minimize(puzzle, table_type);
+  return puzzle;
+}
+
+// Private methods ----------------------------------------------
+
+/*!
+  \brief Checks whether the clues given to a solver have one solution
+
+  The conclusions drawn by propagate() are rolled back afterwards, so that
+  clues can still be removed.
+*/
+bool PuzzleGenerator::unique(CspSolver &solver) {
+  solver.push_checkpoint();
+  solver.propagate();
+  const bool one = (solver.count_solutions(2) == 1);
+  solver.rollback();
+  return one;
+}
+
+/*!
+  \brief Decides which clues in [first, last) are needed
+
+  \param[in,out] solver Has been given every kept clue outside the range
+  \param[in] puzzle The puzzle whose clues are tested
+  \param[in] items The fact items of solver
+  \param[in,out] kept Whether each clue is still part of the puzzle
+  \param[in] first The first clue of the range
+  \param[in] last One past the last clue of the range
+*/
+void PuzzleGenerator::reduce(CspSolver &solver, const Puzzle &puzzle,
+                             const FactItems &items, std::vector<bool> &kept,
+                             int first, int last) {
+  if (last - first == 1) {
+    // All kept clues but this one are given
+    kept[first] = !unique(solver);
+    return;
+  }
+
+  const int middle = (first + last)/2;
+  solver.push_checkpoint();
+  for (int i = middle; i < last; ++i) {
+    if (kept[i]) {
+      puzzle.apply(solver, items, puzzle.clues[i]);
+    }
+  }
+  reduce(solver, puzzle, items, kept, first, middle);
+  solver.rollback();
+
+  solver.push_checkpoint();
+  for (int i = first; i < middle; ++i) {
+    if (kept[i]) {
+      puzzle.apply(solver, items, puzzle.clues[i]);
+    }
+  }
+  reduce(solver, puzzle, items, kept, middle, last);
+  solver.rollback();
+}
+
+/*!
+  \brief Draws a number in [0, n) the same way on every platform
+*/
+int PuzzleGenerator::random(int n) {
+  return rng() % n;
+}
+
+/*!
+  \brief Draws a clue that holds for the solution of the puzzle
+
+  The two items are always of different properties.
+*/
+Clue PuzzleGenerator::random_clue(const Puzzle &puzzle) {
+  const int n = puzzle.num_values;
+  const int p = puzzle.num_properties;
+  Clue clue;
+  clue.property = 0;
+  clue.relation = OFFSET;
+  clue.distance = 0;
+
+  const int kind = random(4);
+  const int house1 = random(n);
+  const int house2 = (house1 + 1 + random(n - 1)) % n;
+  clue.type1 = random(p);
+  clue.type2 = (clue.type1 + 1 + random(p - 1)) % p;
+
+  if (kind == 0) {
+    // The two items are in the same house
+    clue.type = CONNECT;
+    clue.value1 = puzzle.solution[clue.type1][house1];
+    clue.value2 = puzzle.solution[clue.type2][house1];
+    return clue;
+  }
+
+  clue.value1 = puzzle.solution[clue.type1][house1];
+  clue.value2 = puzzle.solution[clue.type2][house2];
+  if (kind == 1) {
+    clue.type = DISCONNECT;
+    return clue;
+  }
+
+  // A positional clue between two houses
+  clue.type = RELATE;
+  const int offset = house2 - house1;
+  std::vector<Relation> relations = {OFFSET, DISTANCE};
+  if (std::abs(offset) == 1) {
+    relations.push_back(ADJACENT);
+  }
+  relations.push_back(offset > 0 ? LEFT_OF : RIGHT_OF);
+  clue.relation = relations[random(relations.size())];
+  clue.distance = (clue.relation == DISTANCE) ? std::abs(offset) : offset;
+  return clue;
+}
@@ -0,0 +1,101 @@
+#ifndef PUZZLE_H
+#define PUZZLE_H
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "csp_solver.h"
+
+typedef enum {
+  CONNECT = 0,
+  DISCONNECT,
+  RELATE} ClueType;
+
+/*!
+  \brief One clue of a puzzle, in terms of property and value indices
+*/
+class Clue {
+
+  public:
+    ClueType type;
+    int type1;
+    int value1;
+    int type2;
+    int value2;
+    // Only used by RELATE
+    int property;
+    Relation relation;
+    int distance;
+};
+
+typedef std::vector<std::unique_ptr<FactItem>> FactItems;
+
+/*!
+  \brief A Zebra-style puzzle with N houses and P properties
+
+  The generated puzzles measure positional clues along property 0, the
+  house number, and their values are named by their number. Puzzles read
+  from a file have the names of the file.
+*/
+class Puzzle {
+
+public:
+
+  Puzzle(int num_values, int num_properties);
+
+  int num_values;
+  int num_properties;
+  std::vector<Clue> clues;
+
+  // The value of each property in each house, solution[property][house],
+  // only known for generated puzzles
+  std::vector<std::vector<int>> solution;
+
+  // Optional names, numbers are used where they are empty
+  std::string name;
+  std::vector<std::string> category_names;
+  std::vector<std::vector<std::string>> item_names;
+
+  std::string category_name(int property) const;
+  std::string item_name(int property, int value) const;
+
+  FactItems make_items(CspSolver &solver) const;
+  void apply(CspSolver &solver, const FactItems &items,
+             const Clue &clue) const;
+  void pose(CspSolver &solver) const;
+};
+
+/*!
+  \brief Makes random puzzles that have exactly one solution
+
+  A hidden solution is drawn first and clues that are true for it are added
+  until the solver finds no other solution. minimize() then drops the clues
+  that the others make redundant. The same seed always gives the same
+  puzzles.
+*/
+class PuzzleGenerator {
+
+public:
+
+  explicit PuzzleGenerator(uint32_t seed);
+
+  Puzzle generate(int num_values, int num_properties,
+                  TableType table_type = DENSE_TABLE);
+  void minimize(Puzzle &puzzle, TableType table_type = DENSE_TABLE);
+  Puzzle generate_minimal(int num_values, int num_properties,
+                          TableType table_type = DENSE_TABLE);
+
+private:
+
+  std::mt19937 rng;
+
+  int random(int n);
+  Clue random_clue(const Puzzle &puzzle);
+  bool unique(CspSolver &solver);
+  void reduce(CspSolver &solver, const Puzzle &puzzle, const FactItems &items,
+              std::vector<bool> &kept, int first, int last);
+};
+
+#endif
@@ -0,0 +1,778 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "puzzle_cache.h"
+
+namespace {
+
+// A clue between two items, oriented so that swapping its items or using
+// the mirrored relation gives the same link
+class Link {
+
+  public:
+    int kind;
+    int distance;
+    int item1;
+    int item2;
+    int along;  // Property vertex, or -1
+    bool symmetric;
+};
+
+enum {
+  ROLE_EITHER = 0,
+  ROLE_FROM,
+  ROLE_TO,
+  ROLE_ALONG};
+
+/*!
+  \brief Finds the canonical labelling of the graph of a puzzle
+
+  Vertices 0..P-1 are the properties and P + p*N + v the values.
+*/
+class Labeller {
+
+public:
+
+  Labeller(const Puzzle &puzzle);
+
+  void search(std::vector<int> colors);
+
+  int num_leaves;
+  std::vector<int32_t> best_form;
+  std::vector<int> best_property;
+  std::vector<int> best_value;
+
+private:
+
+  int N;
+  int P;
+  int num_vertices;
+  std::vector<Link> links;
+  // (link, role) of each vertex
+  std::vector<std::vector<std::pair<int, int>>> incidences;
+  std::vector<bool> isolated;
+
+  void refine(std::vector<int> &colors) const;
+  static int rank(const std::vector<std::vector<int>> &signatures,
+                  std::vector<int> &colors);
+  void leaf(const std::vector<int> &colors);
+};
+
+Labeller::Labeller(const Puzzle &puzzle)
+  : num_leaves(0), N(puzzle.num_values), P(puzzle.num_properties),
+    num_vertices(P + P*N), incidences(num_vertices),
+    isolated(num_vertices, true) {
+  for (const Clue &clue : puzzle.clues) {
+    Link link;
+    link.kind = clue.type;
+    link.distance = 0;
+    link.item1 = P + clue.type1*N + clue.value1;
+    link.item2 = P + clue.type2*N + clue.value2;
+    link.along = -1;
+    link.symmetric = true;
+    if (clue.type == RELATE) {
+      Relation relation = clue.relation;
+      link.distance = clue.distance;
+      link.along = clue.property;
+      if (relation == RIGHT_OF) {
+        relation = LEFT_OF;
+        std::swap(link.item1, link.item2);
+      }
+      if (relation == OFFSET && link.distance < 0) {
+        link.distance = -link.distance;
+        std::swap(link.item1, link.item2);
+      }
+      if (relation == ADJACENT || relation == LEFT_OF) {
+        link.distance = 0;
+      }
+      if (relation == DISTANCE) {
+        link.distance = std::abs(link.distance);
+      }
+      link.kind = RELATE + relation;
+      link.symmetric = (relation == ADJACENT || relation == DISTANCE ||
+                        (relation == OFFSET && link.distance == 0));
+    }
+
+    const int l = links.size();
+    links.push_back(link);
+    incidences[link.item1].push_back({l, link.symmetric ? ROLE_EITHER :
+                                          ROLE_FROM});
+    incidences[link.item2].push_back({l, link.symmetric ? ROLE_EITHER :
+                                          ROLE_TO});
+    isolated[link.item1] = false;
+    isolated[link.item2] = false;
+    if (link.along >= 0) {
+      incidences[link.along].push_back({l, ROLE_ALONG});
+      isolated[link.along] = false;
+    }
+  }
+  for (int p = 0; p < P; ++p) {
+    for (int v = 0; v < N; ++v) {
+      isolated[p] = isolated[p] && isolated[P + p*N + v];
+    }
+  }
+}
+
+/*!
+  \brief Tries the ways to break the ties left after refining
+*/
+void Labeller::search(std::vector<int> colors) {
+  refine(colors);
+
+  // The first colour shared by several vertices
+  std::vector<int> count(num_vertices, 0);
+  for (int color : colors) {
+    ++count[color];
+  }
+  int cell = -1;
+  for (int color = 0; color < num_vertices && cell < 0; ++color) {
+    if (count[color] > 1) {
+      cell = color;
+    }
+  }
+  if (cell < 0) {
+    leaf(colors);
+    return;
+  }
+
+  for (int u = 0; u < num_vertices; ++u) {
+    if (colors[u] != cell) {
+      continue;
+    }
+    // Give u a colour of its own, just before the rest of its cell
+    std::vector<int> split(num_vertices);
+    for (int w = 0; w < num_vertices; ++w) {
+      split[w] = 2*colors[w] + (w != u);
+    }
+    search(split);
+    // Vertices that no clue mentions all give the same form
+    if (isolated[u] || num_leaves >= PuzzleKey::LEAF_LIMIT) {
+      break;
+    }
+  }
+}
+
+void Labeller::refine(std::vector<int> &colors) const {
+  std::vector<std::vector<int>> signatures(num_vertices);
+  int num_colors = rank(std::vector<std::vector<int>>(), colors);
+  for (;;) {
+    for (int u = 0; u < num_vertices; ++u) {
+      std::vector<std::vector<int>> tuples;
+      if (u < P) {
+        for (int v = 0; v < N; ++v) {
+          tuples.push_back({-1, colors[P + u*N + v]});
+        }
+      }
+      else {
+        tuples.push_back({-2, colors[(u - P)/N]});
+      }
+      for (const std::pair<int, int> &incidence : incidences[u]) {
+        const Link &link = links[incidence.first];
+        const int along = link.along >= 0 ? colors[link.along] : -1;
+        const int color1 = colors[link.item1];
+        const int color2 = colors[link.item2];
+        switch (incidence.second) {
+        case ROLE_EITHER:
+          tuples.push_back({link.kind, link.distance, ROLE_EITHER,
+                            u == link.item1 ? color2 : color1, along});
+          break;
+        case ROLE_FROM:
+          tuples.push_back({link.kind, link.distance, ROLE_FROM, color2,
+                            along});
+          break;
+        case ROLE_TO:
+          tuples.push_back({link.kind, link.distance, ROLE_TO, color1,
+                            along});
+          break;
+        case ROLE_ALONG:
+          tuples.push_back({link.kind, link.distance, ROLE_ALONG,
+                            link.symmetric ? std::min(color1, color2) : color1,
+                            link.symmetric ? std::max(color1, color2) :
+                            color2});
+          break;
+        }
+      }
+      std::sort(tuples.begin(), tuples.end());
+
+      std::vector<int> &signature = signatures[u];
+      signature.assign(1, colors[u]);
+      for (const std::vector<int> &tuple : tuples) {
+        signature.insert(signature.end(), tuple.begin(), tuple.end());
+      }
+    }
+    const int refined = rank(signatures, colors);
+    if (refined == num_colors) {
+      return;
+    }
+    num_colors = refined;
+  }
+}
+
+/*!
+  \brief Numbers the vertices by the order of their signatures, or of
+         their colours if there are no signatures
+
+  \return The number of colours
+*/
+int Labeller::rank(const std::vector<std::vector<int>> &signatures,
+                   std::vector<int> &colors) {
+  const int n = colors.size();
+  std::vector<std::vector<int>> keys = signatures;
+  if (keys.empty()) {
+    for (int u = 0; u < n; ++u) {
+      keys.push_back({colors[u]});
+    }
+  }
+  std::vector<int> order(n);
+  for (int u = 0; u < n; ++u) {
+    order[u] = u;
+  }
+  std::sort(order.begin(), order.end(), [&keys](int a, int b) {
+      return keys[a] < keys[b];
+    });
+  int color = -1;
+  for (int i = 0; i < n; ++i) {
+    if (i == 0 || keys[order[i]] != keys[order[i - 1]]) {
+      ++color;
+    }
+    colors[order[i]] = color;
+  }
+  return color + 1;
+}
+
+void Labeller::leaf(const std::vector<int> &colors) {
+  ++num_leaves;
+
+  std::vector<int> properties(P);
+  std::vector<int> values(P*N);
+  std::vector<int> order(P);
+  for (int p = 0; p < P; ++p) {
+    order[p] = p;
+  }
+  std::sort(order.begin(), order.end(), [&colors](int a, int b) {
+      return colors[a] < colors[b];
+    });
+  for (int i = 0; i < P; ++i) {
+    properties[order[i]] = i;
+  }
+  std::vector<int> items(N);
+  for (int p = 0; p < P; ++p) {
+    for (int v = 0; v < N; ++v) {
+      items[v] = v;
+    }
+    std::sort(items.begin(), items.end(), [&](int a, int b) {
+        return colors[P + p*N + a] < colors[P + p*N + b];
+      });
+    for (int i = 0; i < N; ++i) {
+      values[p*N + items[i]] = i;
+    }
+  }
+
+  std::vector<std::vector<int32_t>> tuples;
+  for (const Link &link : links) {
+    int item1[2] = {properties[(link.item1 - P)/N],
+                    values[link.item1 - P]};
+    int item2[2] = {properties[(link.item2 - P)/N],
+                    values[link.item2 - P]};
+    if (link.symmetric && std::lexicographical_compare(item2, item2 + 2,
+                                                       item1, item1 + 2)) {
+      std::swap(item1, item2);
+    }
+    tuples.push_back({link.kind, link.distance, item1[0], item1[1],
+                      item2[0], item2[1],
+                      link.along >= 0 ? properties[link.along] : -1});
+  }
+  std::sort(tuples.begin(), tuples.end());
+  tuples.erase(std::unique(tuples.begin(), tuples.end()), tuples.end());
+
+  std::vector<int32_t> form = {N, P, (int32_t)tuples.size()};
+  for (const std::vector<int32_t> &tuple : tuples) {
+    form.insert(form.end(), tuple.begin(), tuple.end());
+  }
+  if (best_form.empty() || form < best_form) {
+    best_form.swap(form);
+    best_property.swap(properties);
+    best_value.swap(values);
+  }
+}
+
+// Records are padded to this many bytes
+const std::size_t ALIGNMENT = 8;
+
+const char MAGIC[8] = {'Z', 'E', 'B', 'R', 'A', 'S', 'C', '1'};
+const uint64_t VERSION = 1;
+const std::size_t INITIAL_SLOTS = 1024;
+
+class Record {
+
+  public:
+    uint32_t form_size;
+    uint8_t result;
+    uint8_t num_values;
+    uint8_t num_properties;
+    uint8_t unused;
+    // Followed by int32_t form[form_size] and, for a unique solution,
+    // uint8_t rows[num_values*num_properties] in canonical labels
+
+    const int32_t *form() const {
+      return reinterpret_cast<const int32_t *>(this + 1);
+    }
+    const uint8_t *rows() const {
+      return reinterpret_cast<const uint8_t *>(form() + form_size);
+    }
+};
+
+std::size_t padded(std::size_t bytes) {
+  return (bytes + ALIGNMENT - 1)/ALIGNMENT*ALIGNMENT;
+}
+
+std::size_t record_size(std::size_t form_size, SolveResult result,
+                        int num_values, int num_properties) {
+  return padded(sizeof(Record) + form_size*sizeof(int32_t) +
+                (result == UNIQUE_SOLUTION ? num_values*num_properties : 0));
+}
+
+}
+
+// PuzzleKey ----------------------------------------------------
+
+/*!
+  \brief Finds the canonical form of a puzzle
+*/
+PuzzleKey::PuzzleKey(const Puzzle &puzzle)
+  : NUM_VALUES(puzzle.num_values), NUM_PROPERTIES(puzzle.num_properties) {
+  const int N = NUM_VALUES;
+  const int P = NUM_PROPERTIES;
+
+  // Properties come before values, and the values of a property that
+  // positions are measured along keep their order
+  std::vector<bool> ordinal(P, false);
+  for (const Clue &clue : puzzle.clues) {
+    if (clue.type == RELATE) {
+      ordinal[clue.property] = true;
+    }
+  }
+  std::vector<int> colors(P + P*N);
+  for (int p = 0; p < P; ++p) {
+    colors[p] = ordinal[p];
+    for (int v = 0; v < N; ++v) {
+      colors[P + p*N + v] = 2 + (ordinal[p] ? v + 1 : 0);
+    }
+  }
+
+  Labeller labeller(puzzle);
+  labeller.search(colors);
+  canonical_form.swap(labeller.best_form);
+  canonical_property.swap(labeller.best_property);
+  canonical_value.swap(labeller.best_value);
+
+  original_property.resize(P);
+  original_value.resize(P*N);
+  for (int p = 0; p < P; ++p) {
+    original_property[canonical_property[p]] = p;
+    for (int v = 0; v < N; ++v) {
+      original_value[canonical_property[p]*N + canonical_value[p*N + v]] = v;
+    }
+  }
+
+  // FNV-1a
+  form_hash = 14695981039346656037ULL;
+  for (int32_t word : canonical_form) {
+    for (int byte = 0; byte < 4; ++byte) {
+      form_hash ^= (uint32_t(word) >> (8*byte)) & 0xff;
+      form_hash *= 1099511628211ULL;
+    }
+  }
+}
+
+/*!
+  \brief Relabels the rows of a solution of the puzzle for the canonical
+         form
+
+  \return The rows in canonical labels, sorted
+*/
+std::vector<Factoid> PuzzleKey::to_canonical(
+  const std::vector<Factoid> &rows) const {
+  std::vector<Factoid> canonical;
+  for (const Factoid &row : rows) {
+    Factoid relabelled(NUM_PROPERTIES);
+    for (int p = 0; p < NUM_PROPERTIES; ++p) {
+      relabelled[canonical_property[p]] =
+        canonical_value[p*NUM_VALUES + row[p]];
+    }
+    canonical.push_back(relabelled);
+  }
+  std::sort(canonical.begin(), canonical.end());
+  return canonical;
+}
+
+/*!
+  \brief Relabels the rows of a canonical solution for the puzzle
+*/
+std::vector<Factoid> PuzzleKey::from_canonical(
+  const std::vector<Factoid> &rows) const {
+  std::vector<Factoid> original;
+  for (const Factoid &row : rows) {
+    Factoid relabelled(NUM_PROPERTIES);
+    for (int p = 0; p < NUM_PROPERTIES; ++p) {
+      relabelled[original_property[p]] =
+        original_value[p*NUM_VALUES + row[p]];
+    }
+    original.push_back(relabelled);
+  }
+  return original;
+}
+
+// SolutionCache ------------------------------------------------
+
+struct SolutionCache::Header {
+  char magic[8];
+  uint64_t version;
+  uint64_t num_slots;
+  uint64_t num_entries;
+  uint64_t data_end;  // Offset just after the last record
+};
+
+/*!
+  \brief Opens a cache file, or creates it if it doesn't exist
+
+  \param path The file, is_open() tells whether it could be used
+*/
+SolutionCache::SolutionCache(const std::string &path)
+  : path(path), fd(-1), base(nullptr), mapped(0) {
+  open_file();
+}
+
+SolutionCache::~SolutionCache() {
+  unmap();
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+/*!
+  \brief Looks up the result of a puzzle
+
+  \param[in] key The canonical form of the puzzle
+  \param[out] result Whether it has no, one or several solutions
+  \param[out] rows The solution, one factoid per house in the labels of
+                   the puzzle, if it is unique
+  \return false if the puzzle isn't in the cache
+*/
+bool SolutionCache::find(const PuzzleKey &key, SolveResult &result,
+                         std::vector<Factoid> &rows) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!base) {
+    return false;
+  }
+  bool found;
+  const int64_t slot = probe(key, found);
+  if (slot < 0) {
+    corrupt();
+    return false;
+  }
+  if (!found) {
+    return false;
+  }
+
+  const Record *record =
+    reinterpret_cast<const Record *>(base + slots()[2*slot + 1]);
+  rows.clear();
+  if (record->result == UNIQUE_SOLUTION) {
+    std::vector<Factoid> canonical(record->num_values,
+                                   Factoid(record->num_properties));
+    const uint8_t *fields = record->rows();
+    for (Factoid &row : canonical) {
+      for (int &value : row) {
+        value = *fields++;
+        if (value >= record->num_values) {
+          corrupt();
+          return false;
+        }
+      }
+    }
+    rows = key.from_canonical(canonical);
+  }
+  result = SolveResult(record->result);
+  return true;
+}
+
+/*!
+  \brief Stores the result of a puzzle
+
+  \param key The canonical form of the puzzle
+  \param result Whether it has no, one or several solutions
+  \param rows The solution in the labels of the puzzle if it is unique
+*/
+void SolutionCache::insert(const PuzzleKey &key, SolveResult result,
+                           const std::vector<Factoid> &rows) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!base || key.form()[0] > 255 || key.form()[1] > 255) {
+    return;
+  }
+  bool found;
+  if (probe(key, found) < 0) {
+    corrupt();
+    return;
+  }
+  if (found) {
+    return;
+  }
+
+  const std::vector<int32_t> &form = key.form();
+  const int num_values = form[0];
+  const int num_properties = form[1];
+  const std::size_t size = record_size(form.size(), result, num_values,
+                                       num_properties);
+  if (!reserve(size)) {
+    return;
+  }
+
+  const uint64_t offset = header()->data_end;
+  Record *record = reinterpret_cast<Record *>(base + offset);
+  std::memset(record, 0, size);
+  record->form_size = form.size();
+  record->result = result;
+  record->num_values = num_values;
+  record->num_properties = num_properties;
+  std::memcpy(record + 1, form.data(), form.size()*sizeof(int32_t));
+  if (result == UNIQUE_SOLUTION) {
+    uint8_t *fields = reinterpret_cast<uint8_t *>(
+      reinterpret_cast<int32_t *>(record + 1) + form.size());
+    for (const Factoid &row : key.to_canonical(rows)) {
+      for (int value : row) {
+        *fields++ = value;
+      }
+    }
+  }
+  header()->data_end += size;
+
+  const int64_t slot = probe(key, found);
+  if (slot < 0) {
+    corrupt();
+    return;
+  }
+  slots()[2*slot] = key.hash();
+  slots()[2*slot + 1] = offset;
+  ++header()->num_entries;
+  if (2*header()->num_entries > header()->num_slots) {
+    rebuild();
+  }
+}
+
+/*!
+  \brief Gets the number of puzzles in the cache
+*/
+std::size_t SolutionCache::size() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return base ? header()->num_entries : 0;
+}
+
+// Private methods ----------------------------------------------
+
+uint64_t *SolutionCache::slots() const {
+  return reinterpret_cast<uint64_t *>(base + sizeof(Header));
+}
+
+bool SolutionCache::open_file() {
+  fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    message = "can't open " + path;
+    return false;
+  }
+  // Held until the file is closed, by the destructor or a rebuild
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    message = errno == EWOULDBLOCK ?
+      path + " is in use by another process" : "can't lock " + path;
+    return false;
+  }
+  struct stat info;
+  fstat(fd, &info);
+
+  if (info.st_size == 0) {
+    const std::size_t data_start = sizeof(Header) +
+      2*INITIAL_SLOTS*sizeof(uint64_t);
+    if (ftruncate(fd, 2*data_start) != 0 || !map(2*data_start)) {
+      message = "can't grow " + path;
+      return false;
+    }
+    Header *head = header();
+    std::memcpy(head->magic, MAGIC, sizeof(MAGIC));
+    head->version = VERSION;
+    head->num_slots = INITIAL_SLOTS;
+    head->num_entries = 0;
+    head->data_end = data_start;
+    return true;
+  }
+
+  if ((std::size_t)info.st_size < sizeof(Header) || !map(info.st_size)) {
+    message = path + " isn't a solution cache";
+    return false;
+  }
+  const Header *head = header();
+  const uint64_t num_slots = head->num_slots;
+  if (std::memcmp(head->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      head->version != VERSION ||
+      num_slots == 0 || (num_slots & (num_slots - 1)) != 0 ||
+      num_slots > (mapped - sizeof(Header))/(2*sizeof(uint64_t)) ||
+      head->num_entries >= num_slots ||
+      sizeof(Header) + 2*num_slots*sizeof(uint64_t) > head->data_end ||
+      head->data_end > mapped) {
+    unmap();
+    message = path + " isn't a solution cache of this version";
+    return false;
+  }
+  return true;
+}
+
+/*!
+  \brief Stops using a file found to be corrupt
+*/
+void SolutionCache::corrupt() {
+  unmap();
+  message = path + " isn't a solution cache";
+}
+
+bool SolutionCache::map(std::size_t size) {
+  unmap();
+  void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+  if (address == MAP_FAILED) {
+    return false;
+  }
+  base = static_cast<char *>(address);
+  mapped = size;
+  return true;
+}
+
+void SolutionCache::unmap() {
+  if (base) {
+    munmap(base, mapped);
+    base = nullptr;
+    mapped = 0;
+  }
+}
+
+/*!
+  \brief Makes room for a record after the last one, doubling the file
+*/
+bool SolutionCache::reserve(std::size_t bytes) {
+  const std::size_t needed = header()->data_end + bytes;
+  if (needed <= mapped) {
+    return true;
+  }
+  const std::size_t size = std::max(2*mapped, needed);
+  if (ftruncate(fd, size) != 0 || !map(size)) {
+    message = "can't grow " + path;
+    return false;
+  }
+  return true;
+}
+
+/*!
+  \brief Writes the cache to a new file with twice the slots and moves it
+         over the old one
+*/
+void SolutionCache::rebuild() {
+  const Header old = *header();
+  const std::size_t old_start = sizeof(Header) +
+    2*old.num_slots*sizeof(uint64_t);
+  const uint64_t num_slots = 2*old.num_slots;
+  const std::size_t start = sizeof(Header) + 2*num_slots*sizeof(uint64_t);
+  const std::size_t end = start + (old.data_end - old_start);
+
+  std::vector<char> image(2*end, 0);
+  Header *head = reinterpret_cast<Header *>(image.data());
+  *head = old;
+  head->num_slots = num_slots;
+  head->data_end = end;
+  std::memcpy(image.data() + start, base + old_start,
+              old.data_end - old_start);
+  uint64_t *new_slots = reinterpret_cast<uint64_t *>(head + 1);
+  for (uint64_t s = 0; s < old.num_slots; ++s) {
+    const uint64_t hash = slots()[2*s];
+    const uint64_t offset = slots()[2*s + 1];
+    if (!offset) {
+      continue;
+    }
+    uint64_t slot = hash & (num_slots - 1);
+    while (new_slots[2*slot + 1]) {
+      slot = (slot + 1) & (num_slots - 1);
+    }
+    new_slots[2*slot] = hash;
+    new_slots[2*slot + 1] = offset - old_start + start;
+  }
+
+  const std::string temporary = path + ".tmp";
+  const int new_fd = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC,
+                          0644);
+  if (new_fd < 0 || flock(new_fd, LOCK_EX | LOCK_NB) != 0 ||
+      write(new_fd, image.data(), image.size()) != (ssize_t)image.size() ||
+      std::rename(temporary.c_str(), path.c_str()) != 0) {
+    // Keep going with the fuller table
+    if (new_fd >= 0) {
+      close(new_fd);
+      unlink(temporary.c_str());
+    }
+    return;
+  }
+  unmap();
+  close(fd);
+  fd = new_fd;
+  if (!map(image.size())) {
+    message = "can't map " + path;
+  }
+}
+
+/*!
+  \brief Finds the slot of a puzzle, or the free slot where it would go
+
+  \return The slot, or -1 if a record the slots point at lies outside the
+          data or doesn't fit it, or there is no free slot
+*/
+int64_t SolutionCache::probe(const PuzzleKey &key, bool &found) const {
+  const std::vector<int32_t> &form = key.form();
+  const uint64_t num_slots = header()->num_slots;
+  const uint64_t data_start = sizeof(Header) + 2*num_slots*sizeof(uint64_t);
+  const uint64_t data_end = header()->data_end;
+  const uint64_t *table = slots();
+  uint64_t slot = key.hash() & (num_slots - 1);
+  for (uint64_t step = 0; step < num_slots; ++step) {
+    const uint64_t offset = table[2*slot + 1];
+    if (!offset) {
+      found = false;
+      return slot;
+    }
+    if (table[2*slot] == key.hash()) {
+      if (offset < data_start || offset % ALIGNMENT != 0 ||
+          offset > data_end - sizeof(Record)) {
+        return -1;
+      }
+      const Record *record = reinterpret_cast<const Record *>(base + offset);
+      if (record->result > MANY_SOLUTIONS ||
+          record_size(record->form_size, SolveResult(record->result),
+                      record->num_values, record->num_properties) >
+          data_end - offset) {
+        return -1;
+      }
+      if (record->form_size == form.size() &&
+          std::equal(form.begin(), form.end(), record->form())) {
+        if (record->num_values != form[0] ||
+            record->num_properties != form[1]) {
+          return -1;
+        }
+        found = true;
+        return slot;
+      }
+    }
+    slot = (slot + 1) & (num_slots - 1);
+  }
+  return -1;
+}
@@ -0,0 +1,116 @@
+#ifndef PUZZLE_CACHE_H
+#define PUZZLE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "puzzle.h"
+
+typedef enum {
+  NO_SOLUTION = 0,
+  UNIQUE_SOLUTION,
+  MANY_SOLUTIONS} SolveResult;
+
+/*!
+  \brief The canonical form of a puzzle, the same for all puzzles that only
+         differ in naming and order
+
+  The form doesn't change when the properties are listed in another order,
+  the values of a property are listed in another order, or the clues are
+  given in another order or with their items swapped, e.g. "left A B" as
+  "right B A". The values of a property that positional clues are measured
+  along keep their order, as it means something.
+
+  Properties and values are told apart by colour refinement on the graph of
+  clues. Ties that remain are broken by trying each candidate and keeping
+  the smallest form, except for values and properties that no clue
+  mentions, which are interchangeable anyway. After LEAF_LIMIT tries the
+  first candidate is taken, so very symmetric puzzles may get more than one
+  form. That only costs cache hits, the form is always exact.
+*/
+class PuzzleKey {
+
+public:
+
+  static const int LEAF_LIMIT = 256;
+
+  explicit PuzzleKey(const Puzzle &puzzle);
+
+  const std::vector<int32_t> &form() const { return canonical_form; }
+  uint64_t hash() const { return form_hash; }
+
+  std::vector<Factoid> to_canonical(const std::vector<Factoid> &rows) const;
+  std::vector<Factoid> from_canonical(const std::vector<Factoid> &rows) const;
+
+private:
+
+  int NUM_VALUES;
+  int NUM_PROPERTIES;
+
+  std::vector<int32_t> canonical_form;
+  uint64_t form_hash;
+
+  // canonical_property[p] and canonical_value[p*N + v] of the puzzle's
+  // property p and value v, and back
+  std::vector<int> canonical_property;
+  std::vector<int> canonical_value;
+  std::vector<int> original_property;
+  std::vector<int> original_value;
+};
+
+/*!
+  \brief Results of solved puzzles, kept in a memory-mapped file
+
+  The file has a header, an open addressing table of (hash, offset) slots
+  and the records, each holding a canonical form and the result for it in
+  canonical labels. Looking up a puzzle hashes its form, probes the slots
+  and compares the stored form, so a hash collision can't give a wrong
+  answer. The table is rebuilt into a new file with twice the slots when
+  it gets half full.
+
+  The file is in the byte order of the machine and only one process may
+  use it at a time, it is locked with flock() while open. A cache can be
+  shared by threads. Puzzles with more than 255 values per property aren't
+  cached.
+*/
+class SolutionCache {
+
+public:
+
+  explicit SolutionCache(const std::string &path);
+  ~SolutionCache();
+
+  bool is_open() const { return base != nullptr; }
+  const std::string &error() const { return message; }
+  bool find(const PuzzleKey &key, SolveResult &result,
+            std::vector<Factoid> &rows);
+  void insert(const PuzzleKey &key, SolveResult result,
+              const std::vector<Factoid> &rows);
+  std::size_t size();
+
+private:
+
+  struct Header;
+
+  std::string path;
+  std::string message;
+  int fd;
+  char *base;
+  std::size_t mapped;
+  std::mutex mutex;
+
+  Header *header() const { return reinterpret_cast<Header *>(base); }
+  uint64_t *slots() const;
+
+  bool open_file();
+  bool map(std::size_t size);
+  void unmap();
+  void corrupt();
+  bool reserve(std::size_t bytes);
+  void rebuild();
+  int64_t probe(const PuzzleKey &key, bool &found) const;
+};
+
+#endif
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <sstream>
+#include <vector>
+#include "puzzle_format.h"
+
+namespace {
+
+class ClueWord {
+
+  public:
+    const char *word;
+    ClueType type;
+    Relation relation;
+    bool has_distance;
+};
+
+const ClueWord CLUE_WORDS[] = {
+  {"same", CONNECT, OFFSET, false},
+  {"not", DISCONNECT, OFFSET, false},
+  {"offset", RELATE, OFFSET, true},
+  {"adjacent", RELATE, ADJACENT, false},
+  {"left", RELATE, LEFT_OF, false},
+  {"right", RELATE, RIGHT_OF, false},
+  {"distance", RELATE, DISTANCE, true}};
+
+const ClueWord *find_clue_word(const std::string &word) {
+  for (const ClueWord &clue_word : CLUE_WORDS) {
+    if (word == clue_word.word) {
+      return &clue_word;
+    }
+  }
+  return nullptr;
+}
+
+const ClueWord &clue_word_of(const Clue &clue) {
+  for (const ClueWord &clue_word : CLUE_WORDS) {
+    if (clue.type == clue_word.type &&
+        (clue.type != RELATE || clue.relation == clue_word.relation)) {
+      return clue_word;
+    }
+  }
+  return CLUE_WORDS[0];
+}
+
+}
+
+/*!
+  \brief Constructs a reader
+
+  \param in The stream to read from, it must outlive the reader
+*/
+PuzzleReader::PuzzleReader(std::istream &in) : in(in), line_number(0) {
+}
+
+/*!
+  \brief Reads the next puzzle
+
+  \param[out] puzzle The puzzle that was read
+  \return false at the end of the stream or on an error, in which case
+          error() tells what went wrong
+*/
+bool PuzzleReader::next(Puzzle &puzzle) {
+  std::string name;
+  bool started = false;
+  std::vector<std::string> category_names;
+  std::vector<std::vector<std::string>> item_names;
+  int order = 0;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    ++line_number;
+    const std::size_t comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+    std::istringstream words(line);
+    std::string word;
+    if (!(words >> word)) {
+      continue;
+    }
+
+    if (!started) {
+      if (word != "puzzle") {
+        return fail("expected 'puzzle'");
+      }
+      started = true;
+      words >> name;
+      if (!end_of_statement(words)) {
+        return false;
+      }
+      puzzle = Puzzle(0, 0);
+      continue;
+    }
+
+    if (word == "category") {
+      if (puzzle.num_properties != 0) {
+        return fail("categories must come before the clues");
+      }
+      std::string category;
+      std::vector<std::string> items;
+      words >> category;
+      for (std::string item; words >> item; ) {
+        items.push_back(item);
+      }
+      if (items.empty()) {
+        return fail("category '" + category + "' has no items");
+      }
+      if (std::find(category_names.begin(), category_names.end(),
+                    category) != category_names.end()) {
+        return fail("category '" + category + "' comes twice");
+      }
+      if (items.size() > (std::size_t)MAX_VALUES) {
+        return fail("category '" + category + "' has more than " +
+                    std::to_string(MAX_VALUES) + " items");
+      }
+      for (std::size_t i = 1; i < items.size(); ++i) {
+        if (std::find(items.begin(), items.begin() + i, items[i]) !=
+            items.begin() + i) {
+          return fail("category '" + category + "' has '" + items[i] +
+                      "' twice");
+        }
+      }
+      if (!item_names.empty() && items.size() != item_names[0].size()) {
+        return fail("category '" + category + "' has " +
+                    std::to_string(items.size()) + " items instead of " +
+                    std::to_string(item_names[0].size()));
+      }
+      category_names.push_back(category);
+      item_names.push_back(items);
+      continue;
+    }
+
+    if (category_names.empty()) {
+      return fail("expected 'category'");
+    }
+    if (category_names.size() < 2) {
+      return fail("a puzzle needs at least two categories");
+    }
+    if (puzzle.num_properties == 0) {
+      // The categories are complete
+      puzzle = Puzzle(item_names[0].size(), category_names.size());
+      puzzle.name = name;
+      puzzle.category_names = category_names;
+      puzzle.item_names = item_names;
+    }
+
+    if (word == "end") {
+      return end_of_statement(words);
+    }
+
+    if (word == "order") {
+      std::string category;
+      words >> category;
+      order = -1;
+      for (int property = 0; property < puzzle.num_properties; ++property) {
+        if (category_names[property] == category) {
+          order = property;
+        }
+      }
+      if (order < 0) {
+        return fail("unknown category '" + category + "'");
+      }
+      if (!end_of_statement(words)) {
+        return false;
+      }
+      continue;
+    }
+
+    const ClueWord *clue_word = find_clue_word(word);
+    if (!clue_word) {
+      return fail("unknown statement '" + word + "'");
+    }
+    std::string item1;
+    std::string item2;
+    Clue clue;
+    clue.type = clue_word->type;
+    clue.property = order;
+    clue.relation = clue_word->relation;
+    clue.distance = 0;
+    if (!(words >> item1 >> item2) ||
+        (clue_word->has_distance && !(words >> clue.distance))) {
+      return fail("'" + word + "' needs two items" +
+                  (clue_word->has_distance ? " and a distance" : ""));
+    }
+    if (!end_of_statement(words)) {
+      return false;
+    }
+    if (!find_item(puzzle, item1, clue.type1, clue.value1) ||
+        !find_item(puzzle, item2, clue.type2, clue.value2)) {
+      return false;
+    }
+    if (clue.type != RELATE && clue.type1 == clue.type2) {
+      return fail("'" + word + "' needs items of two categories");
+    }
+    puzzle.clues.push_back(clue);
+  }
+
+  if (started) {
+    return fail("missing 'end'");
+  }
+  message.clear();
+  return false;
+}
+
+// Private methods ----------------------------------------------
+
+bool PuzzleReader::fail(const std::string &what) {
+  message = "line " + std::to_string(line_number) + ": " + what;
+  return false;
+}
+
+/*!
+  \brief Checks that nothing is left of a statement
+
+  \return false if there is, with the first word left in error()
+*/
+bool PuzzleReader::end_of_statement(std::istream &words) {
+  std::string extra;
+  if (words >> extra) {
+    return fail("unexpected '" + extra + "'");
+  }
+  return true;
+}
+
+bool PuzzleReader::find_item(const Puzzle &puzzle, const std::string &token,
+                             int &property, int &value) {
+  std::string category;
+  std::string item = token;
+  const std::size_t dot = token.find('.');
+  if (dot != std::string::npos) {
+    category = token.substr(0, dot);
+    item = token.substr(dot + 1);
+  }
+
+  int found = 0;
+  for (int p = 0; p < puzzle.num_properties; ++p) {
+    if (!category.empty() && puzzle.category_names[p] != category) {
+      continue;
+    }
+    for (int v = 0; v < puzzle.num_values; ++v) {
+      if (puzzle.item_names[p][v] == item) {
+        property = p;
+        value = v;
+        ++found;
+      }
+    }
+  }
+  if (found == 0) {
+    return fail("unknown item '" + token + "'");
+  }
+  if (found > 1) {
+    return fail("'" + token + "' is in several categories, write "
+                "category." + item);
+  }
+  return true;
+}
+
+/*!
+  \brief Writes a puzzle in the format read by PuzzleReader
+
+  Items are qualified by their category where their names are ambiguous,
+  e.g. for generated puzzles, whose items are named by number.
+*/
+void write_puzzle(std::ostream &out, const Puzzle &puzzle) {
+  auto reference = [&puzzle](int property, int value) {
+    const std::string item = puzzle.item_name(property, value);
+    for (int p = 0; p < puzzle.num_properties; ++p) {
+      for (int v = 0; v < puzzle.num_values; ++v) {
+        if (p != property && puzzle.item_name(p, v) == item) {
+          return puzzle.category_name(property) + "." + item;
+        }
+      }
+    }
+    return item;
+  };
+
+  out << "puzzle " << (puzzle.name.empty() ? "unnamed" : puzzle.name)
+      << std::endl;
+  for (int property = 0; property < puzzle.num_properties; ++property) {
+    out << "category " << puzzle.category_name(property);
+    for (int value = 0; value < puzzle.num_values; ++value) {
+      out << " " << puzzle.item_name(property, value);
+    }
+    out << std::endl;
+  }
+
+  int order = 0;
+  for (const Clue &clue : puzzle.clues) {
+    const ClueWord &clue_word = clue_word_of(clue);
+    if (clue.type == RELATE && clue.property != order) {
+      order = clue.property;
+      out << "order " << puzzle.category_name(order) << std::endl;
+    }
+    out << clue_word.word << " " << reference(clue.type1, clue.value1) << " "
+        << reference(clue.type2, clue.value2);
+    if (clue_word.has_distance) {
+      out << " " << clue.distance;
+    }
+    out << std::endl;
+  }
+  out << "end" << std::endl;
+}
@@ -0,0 +1,63 @@
+#ifndef PUZZLE_FORMAT_H
+#define PUZZLE_FORMAT_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include "puzzle.h"
+
+/*!
+  \brief Reads puzzles one at a time from a text stream
+
+  A puzzle looks like this, with one statement per line and # comments:
+
+    puzzle zebra
+    category number 1 2 3 4 5
+    category colour red green ivory yellow blue
+    ...
+    same English red
+    not Spanish tea
+    offset ivory green 1
+    end
+
+  There are at least two categories. All have different names and the
+  same number of items, at most 256, each named once. An item is named by
+  itself or, if the name is used in several categories, as category.item.
+  The items of a same or not clue are of two categories. The clues are
+
+    same A B        A and B belong together
+    not A B         A and B don't belong together
+    offset A B d    position(B) - position(A) == d
+    adjacent A B    |position(B) - position(A)| == 1
+    left A B        position(A) < position(B)
+    right A B       position(A) > position(B)
+    distance A B d  |position(B) - position(A)| == d
+
+  Positions are measured along the items of the first category, in the
+  order they are listed, unless an "order category" line comes before the
+  clue.
+*/
+class PuzzleReader {
+
+public:
+
+  explicit PuzzleReader(std::istream &in);
+
+  bool next(Puzzle &puzzle);
+  const std::string &error() const { return message; }
+
+private:
+
+  std::istream &in;
+  int line_number;
+  std::string message;
+
+  bool fail(const std::string &what);
+  bool end_of_statement(std::istream &words);
+  bool find_item(const Puzzle &puzzle, const std::string &token,
+                 int &property, int &value);
+};
+
+void write_puzzle(std::ostream &out, const Puzzle &puzzle);
+
+#endif
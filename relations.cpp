@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include "relations.h"
+
+/*!
+  \brief Checks the relation for the ordinals of the two fact items
+*/
+bool PositionalClue::holds(int ordinal1, int ordinal2) const {
+  switch (relation) {
+  case OFFSET:
+    return ordinal2 - ordinal1 == distance;
+  case ADJACENT:
+    return std::abs(ordinal2 - ordinal1) == 1;
+  case LEFT_OF:
+    return ordinal1 < ordinal2;
+  case RIGHT_OF:
+    return ordinal1 > ordinal2;
+  case DISTANCE:
+    return std::abs(ordinal2 - ordinal1) == distance;
+  }
+  return false;
+}
+
+/*!
+  \brief Finds the rows that hold the items of each clue
+
+  \param clues The positional clues, must outlive the tracker
+  \param possibilities The rows that combos are built from
+*/
+RelationTracker::RelationTracker(const std::vector<PositionalClue> &clues,
+                                 const PossibilityList &possibilities)
+  : clues(clues) {
+  links.resize(possibilities.size());
+  row_feasible.resize(possibilities.size(), true);
+  placed.resize(2*clues.size(), -1);
+
+  for (std::size_t row = 0; row < possibilities.size(); ++row) {
+    const FactoidView factoid = possibilities[row];
+    for (std::size_t c = 0; c < clues.size(); ++c) {
+      const PositionalClue &clue = clues[c];
+      const int ordinal = factoid[clue.property];
+      const bool has1 = (factoid[clue.type1] == clue.value1);
+      const bool has2 = (factoid[clue.type2] == clue.value2);
+      if (has1 && has2 && !clue.holds(ordinal, ordinal)) {
+        row_feasible[row] = false;
+      }
+      if (has1) {
+        links[row].push_back({(int)c, 0, ordinal});
+      }
+      if (has2) {
+        links[row].push_back({(int)c, 1, ordinal});
+      }
+    }
+  }
+}
+
+/*!
+  \brief Checks whether a row can be part of any combo on its own
+*/
+bool RelationTracker::feasible(int row) const {
+  return row_feasible[row];
+}
+
+/*!
+  \brief Places a row if it is consistent with the rows placed so far
+
+  \return false, leaving nothing placed, if a clue is violated or one of the
+          items of the row is already placed
+*/
+bool RelationTracker::place(int row) {
+  if (!row_feasible[row]) {
+    return false;
+  }
+  for (const Link &link : links[row]) {
+    if (placed[2*link.clue + link.side] >= 0) {
+      return false;
+    }
+    const int other = placed[2*link.clue + 1 - link.side];
+    if (other >= 0) {
+      const bool holds = (link.side == 0) ?
+        clues[link.clue].holds(link.ordinal, other) :
+        clues[link.clue].holds(other, link.ordinal);
+      if (!holds) {
+        return false;
+      }
+    }
+  }
+  for (const Link &link : links[row]) {
+    placed[2*link.clue + link.side] = link.ordinal;
+  }
+  return true;
+}
+
+/*!
+  \brief Removes a row that was placed
+*/
+void RelationTracker::remove(int row) {
+  for (const Link &link : links[row]) {
+    placed[2*link.clue + link.side] = -1;
+  }
+}
+
+/*!
+  \brief Finds the items whose ordinals the clues compare and the rows
+         that hold them
+
+  \param clues The positional clues that combos must satisfy
+  \param possibilities The rows that combos point to
+*/
+RelationFilter::RelationFilter(const std::vector<PositionalClue> &clues,
+                               const PossibilityList &possibilities)
+  : clues(clues) {
+  for (const PositionalClue &clue : clues) {
+    for (const Side side : {Side{clue.type1, clue.value1, clue.property},
+                            Side{clue.type2, clue.value2, clue.property}}) {
+      std::size_t s = 0;
+      while (s < sides.size() &&
+             (sides[s].type != side.type || sides[s].value != side.value ||
+              sides[s].property != side.property)) {
+        ++s;
+      }
+      if (s == sides.size()) {
+        sides.push_back(side);
+      }
+      clue_sides.push_back(s);
+    }
+  }
+
+  // The ordinals are fields of the rows, kept in a byte like them
+  static_assert(MAX_VALUES - 1 <= UINT8_MAX,
+                "an ordinal must fit in a byte, see MAX_VALUES");
+  first_link.reserve(possibilities.size() + 1);
+  for (const FactoidView factoid : possibilities) {
+    first_link.push_back(links.size());
+    for (std::size_t s = 0; s < sides.size(); ++s) {
+      if (factoid[sides[s].type] == sides[s].value) {
+        links.push_back({(int)s, (uint8_t)factoid[sides[s].property]});
+      }
+    }
+  }
+  first_link.push_back(links.size());
+}
+
+/*!
+  \brief Keeps the combos that satisfy every clue
+
+  \param[in] combos Complete combos, with each value of each property once
+  \param[out] survivors The combos that pass, appended in their order
+  \return The number of combos that pass
+*/
+std::size_t RelationFilter::filter(const ComboList &combos,
+                                   ComboList &survivors) const {
+  if (clues.empty()) {
+    survivors.append(combos);
+    return combos.size();
+  }
+
+  // Ordinal of each side in each combo of the batch, side by side
+  std::vector<uint8_t> ordinals(sides.size()*BATCH);
+  std::vector<uint8_t> keep(BATCH);
+
+  std::size_t passed = 0;
+  for (std::size_t first = 0; first < combos.size(); first += BATCH) {
+    const int count = std::min<std::size_t>(BATCH, combos.size() - first);
+
+    for (int c = 0; c < count; ++c) {
+      for (int row : combos[first + c]) {
+        for (int l = first_link[row]; l < first_link[row + 1]; ++l) {
+          ordinals[links[l].side*BATCH + c] = links[l].ordinal;
+        }
+      }
+    }
+
+    std::fill(keep.begin(), keep.begin() + count, 1);
+    for (std::size_t c = 0; c < clues.size(); ++c) {
+      check(clues[c], &ordinals[clue_sides[2*c]*BATCH],
+            &ordinals[clue_sides[2*c + 1]*BATCH], count, keep.data());
+    }
+
+    for (int c = 0; c < count; ++c) {
+      if (keep[c]) {
+        survivors.push_back(combos[first + c]);
+        ++passed;
+      }
+    }
+  }
+  return passed;
+}
+
+// Private methods ----------------------------------------------
+
+/*!
+  \brief Clears keep[c] for each combo c whose ordinals break the clue
+*/
+void RelationFilter::check(const PositionalClue &clue,
+                           const uint8_t *ordinals1, const uint8_t *ordinals2,
+                           int count, uint8_t *keep) const {
+  const int distance = clue.distance;
+  switch (clue.relation) {
+  case OFFSET:
+    for (int c = 0; c < count; ++c) {
+      keep[c] &= (ordinals2[c] - ordinals1[c] == distance);
+    }
+    break;
+  case ADJACENT:
+    for (int c = 0; c < count; ++c) {
+      const int difference = ordinals2[c] - ordinals1[c];
+      keep[c] &= (difference == 1) | (difference == -1);
+    }
+    break;
+  case LEFT_OF:
+    for (int c = 0; c < count; ++c) {
+      keep[c] &= (ordinals1[c] < ordinals2[c]);
+    }
+    break;
+  case RIGHT_OF:
+    for (int c = 0; c < count; ++c) {
+      keep[c] &= (ordinals1[c] > ordinals2[c]);
+    }
+    break;
+  case DISTANCE:
+    for (int c = 0; c < count; ++c) {
+      const int difference = ordinals2[c] - ordinals1[c];
+      keep[c] &= (difference == distance) | (difference == -distance);
+    }
+    break;
+  }
+}
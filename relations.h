@@ -0,0 +1,124 @@
+#ifndef RELATIONS_H
+#define RELATIONS_H
+
+#include <vector>
+#include "csp_types.h"
+
+/*!
+  Positional relations between two fact items, measured along the values of
+  an ordinal property (e.g. the house number), in the order the values were
+  created.
+*/
+typedef enum {
+  OFFSET = 0,  // ordinal(fact2) - ordinal(fact1) == distance
+  ADJACENT,    // |ordinal(fact2) - ordinal(fact1)| == 1
+  LEFT_OF,     // ordinal(fact1) < ordinal(fact2)
+  RIGHT_OF,    // ordinal(fact1) > ordinal(fact2)
+  DISTANCE     // |ordinal(fact2) - ordinal(fact1)| == distance
+} Relation;
+
+class PositionalClue {
+
+  public:
+    int type1;
+    int value1;
+    int type2;
+    int value2;
+    int property;
+    Relation relation;
+    int distance;
+
+    bool holds(int ordinal1, int ordinal2) const;
+};
+
+/*!
+  \brief Checks positional clues while a combo is being put together
+
+  Every row (factoid) that holds one of the items of a clue knows the ordinal
+  it would give that item. When the rows holding both items are placed, the
+  clue is checked right away instead of on the finished combo.
+*/
+class RelationTracker {
+
+public:
+
+  RelationTracker(const std::vector<PositionalClue> &clues,
+                  const PossibilityList &possibilities);
+
+  bool feasible(int row) const;
+  bool place(int row);
+  void remove(int row);
+
+private:
+
+  struct Link {
+    int clue;
+    int side;
+    int ordinal;
+  };
+
+  const std::vector<PositionalClue> &clues;
+  std::vector<std::vector<Link>> links;
+  std::vector<bool> row_feasible;
+
+  // The ordinal of each side of each clue, -1 when not placed yet
+  std::vector<int> placed;
+};
+
+/*!
+  \brief Checks positional clues on finished combos, a batch at a time
+
+  Each row (factoid) knows which items of the clues it holds and the
+  ordinal it gives them, so the rows of a combo scatter the ordinals of all
+  the clue items without searching the combo. The ordinals are written
+  column by column for a batch of combos, so each clue is a tight loop over
+  two byte arrays that the compiler vectorizes, which holds as long as
+  CspSolver refuses more than MAX_VALUES values. The combos that pass every
+  clue are kept in their order.
+
+  This suits clues that are only known after the combos were found, e.g.
+  trying several sets of positional clues on the same combos. The searches
+  check the clues they are given with a RelationTracker instead.
+*/
+class RelationFilter {
+
+public:
+
+  static const int BATCH = 1024;
+
+  RelationFilter(const std::vector<PositionalClue> &clues,
+                 const PossibilityList &possibilities);
+
+  std::size_t filter(const ComboList &combos, ComboList &survivors) const;
+
+private:
+
+  // An item and the property it is measured along
+  struct Side {
+    int type;
+    int value;
+    int property;
+  };
+
+  struct Link {
+    int side;
+    uint8_t ordinal;
+  };
+
+  // Copied, as the solver adds and drops clues
+  const std::vector<PositionalClue> clues;
+
+  std::vector<Side> sides;
+
+  // The sides of each clue, at 2*clue and 2*clue + 1
+  std::vector<int> clue_sides;
+
+  // The sides held by row r, links[first_link[r]] up to first_link[r + 1]
+  std::vector<int> first_link;
+  std::vector<Link> links;
+
+  void check(const PositionalClue &clue, const uint8_t *ordinals1,
+             const uint8_t *ordinals2, int count, uint8_t *keep) const;
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include "sat_cover.h"
+
+/*!
+  \brief Encodes the combos of a list of factoids as clauses
+
+  \param num_values Number of values that each property can take
+  \param num_properties Number of properties
+  \param possibilities The factoids that the combos are made of
+  \param clues Positional clues that the combos must satisfy
+*/
+SatCover::SatCover(int num_values, int num_properties,
+                   const PossibilityList &possibilities,
+                   const std::vector<PositionalClue> &clues) {
+  NUM_VALUES = num_values;
+  NUM_PROPERTIES = num_properties;
+  const int N = NUM_VALUES;
+  const int P = NUM_PROPERTIES;
+
+  true_var = sat.new_var();
+  sat.add_clause({SatSolver::literal(true_var)});
+  for (int i = 0; i < (P - 1)*N*N; ++i) {
+    placed.push_back(sat.new_var());
+  }
+
+  // One value of each property per house and one house per value
+  for (int property = 1; property < P; ++property) {
+    for (int a = 0; a < N; ++a) {
+      std::vector<int> per_house;
+      std::vector<int> per_value;
+      for (int b = 0; b < N; ++b) {
+        per_house.push_back(at(property, b, a));
+        per_value.push_back(at(property, a, b));
+        for (int c = b + 1; c < N; ++c) {
+          sat.add_clause({at(property, b, a) ^ 1, at(property, c, a) ^ 1});
+          sat.add_clause({at(property, a, b) ^ 1, at(property, a, c) ^ 1});
+        }
+      }
+      sat.add_clause(per_house);
+      sat.add_clause(per_value);
+    }
+  }
+
+  // Values that no factoid holds together
+  const int num_items = P*N;
+  std::vector<bool> supported(num_items*num_items, false);
+  for (int row = 0; row < (int)possibilities.size(); ++row) {
+    const FactoidView factoid = possibilities[row];
+    bool in_range = true;
+    for (int property = 0; property < P; ++property) {
+      in_range = in_range && (factoid[property] >= 0) &&
+        (factoid[property] < N);
+    }
+    if (!in_range) {
+      continue;
+    }
+    rows.insert({Factoid(factoid), row});
+    for (int p = 0; p < P; ++p) {
+      for (int q = p + 1; q < P; ++q) {
+        supported[(p*N + factoid[p])*num_items + q*N + factoid[q]] = true;
+      }
+    }
+  }
+  for (int p = 0; p < P; ++p) {
+    for (int q = p + 1; q < P; ++q) {
+      for (int v = 0; v < N; ++v) {
+        for (int w = 0; w < N; ++w) {
+          if (supported[(p*N + v)*num_items + q*N + w]) {
+            continue;
+          }
+          for (int house = 0; house < N; ++house) {
+            sat.add_clause({at(p, v, house) ^ 1, at(q, w, house) ^ 1});
+          }
+        }
+      }
+    }
+  }
+
+  // Pairs of ordinals that a positional clue doesn't allow
+  for (const PositionalClue &clue : clues) {
+    for (int ordinal1 = 0; ordinal1 < N; ++ordinal1) {
+      for (int ordinal2 = 0; ordinal2 < N; ++ordinal2) {
+        if (!clue.holds(ordinal1, ordinal2)) {
+          sat.add_clause({
+              same(clue.type1, clue.value1, clue.property, ordinal1) ^ 1,
+              same(clue.type2, clue.value2, clue.property, ordinal2) ^ 1});
+        }
+      }
+    }
+  }
+}
+
+/*!
+  \brief Finds all combos
+
+  \param[out] combo_list The combos, each sorted and in lexicographic order,
+                         so the list is the same as from the other searches
+*/
+void SatCover::solve(ComboList &combo_list) {
+  const std::size_t first = combo_list.size();
+  solve([&combo_list](const FactCombo &combo) {
+      combo_list.push_back(combo);
+      return true;
+    });
+  combo_list.sort(first);
+}
+
+/*!
+  \brief Visits the combos in the order they are found
+
+  \param[in] visitor Called with each sorted combo, returning false stops
+                     the search
+  \return false if the visitor stopped the search
+*/
+bool SatCover::solve(const ComboVisitor &visitor) {
+  const int N = NUM_VALUES;
+  const int P = NUM_PROPERTIES;
+  Factoid factoid(P);
+  FactCombo combo(N);
+  std::vector<int> blocking;
+
+  while (sat.solve()) {
+    bool complete = true;
+    blocking.clear();
+    for (int house = 0; house < N; ++house) {
+      factoid[0] = house;
+      std::vector<int> chosen;
+      for (int property = 1; property < P; ++property) {
+        for (int value = 0; value < N; ++value) {
+          if (sat.model_value(at(property, value, house) >> 1)) {
+            factoid[property] = value;
+            chosen.push_back(at(property, value, house) ^ 1);
+          }
+        }
+      }
+      blocking.insert(blocking.end(), chosen.begin(), chosen.end());
+
+      // The clauses only see pairs of values, a house may still be a
+      // factoid that isn't in the list
+      const auto row = rows.find(factoid);
+      if (row == rows.end()) {
+        sat.add_clause(chosen);
+        complete = false;
+        break;
+      }
+      combo[house] = row->second;
+    }
+    if (!complete) {
+      continue;
+    }
+
+    std::sort(combo.begin(), combo.end());
+    CSP_STATS_ADD(stats, combos, 1);
+    if (!visitor(combo)) {
+      return false;
+    }
+    if (!sat.add_clause(blocking)) {
+      break;
+    }
+  }
+  return true;
+}
+
+/*!
+  \brief Gets the counters of the SAT solver and the combos found
+*/
+SolverStats SatCover::get_stats() const {
+  SolverStats total = sat.get_stats();
+  total.add(stats);
+  return total;
+}
+
+// Private methods ----------------------------------------------
+
+int SatCover::at(int property, int value, int house) const {
+  if (property == 0) {
+    return constant(value == house);
+  }
+  return SatSolver::literal(
+    placed[((property - 1)*NUM_VALUES + value)*NUM_VALUES + house]);
+}
+
+int SatCover::same(int property1, int value1, int property2, int value2) {
+  if (property1 == property2) {
+    return constant(value1 == value2);
+  }
+  if (property1 == 0) {
+    return at(property2, value2, value1);
+  }
+  if (property2 == 0) {
+    return at(property1, value1, value2);
+  }
+
+  std::pair<int, int> key(property1*NUM_VALUES + value1,
+                          property2*NUM_VALUES + value2);
+  if (key.first > key.second) {
+    std::swap(key.first, key.second);
+  }
+  auto found = together.find(key);
+  if (found != together.end()) {
+    return SatSolver::literal(found->second);
+  }
+
+  // Only ever used negated, so it only has to be true when they do share
+  const int var = sat.new_var();
+  together[key] = var;
+  for (int house = 0; house < NUM_VALUES; ++house) {
+    sat.add_clause({at(property1, value1, house) ^ 1,
+                    at(property2, value2, house) ^ 1,
+                    SatSolver::literal(var)});
+  }
+  return SatSolver::literal(var);
+}
@@ -0,0 +1,68 @@
+#ifndef SAT_COVER_H
+#define SAT_COVER_H
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "csp_types.h"
+#include "relations.h"
+#include "sat_solver.h"
+
+/*!
+  \brief Finds combinations of factoids with a CDCL SAT solver
+
+  A combo has one factoid per value of property 0, so each factoid is named
+  by that value, its "house". There is a variable for each value of each
+  other property being in each house, with clauses saying that every house
+  has one value of every property and every value is in one house. Pairs of
+  values that no factoid holds together may not share a house, and the
+  positional clues rule out the pairs of ordinals they don't allow.
+
+  Each combo that the SAT solver finds is blocked by a clause before it
+  looks for the next one, so the conflicts it learnt carry over. Unlike the
+  searches over the factoids, the work depends on how hard the clues are to
+  combine rather than on how many factoids there are. That suits checking
+  that a puzzle has one solution, listing thousands of combos is faster
+  with Dancing Links.
+*/
+class SatCover {
+
+public:
+
+  SatCover(int num_values, int num_properties,
+           const PossibilityList &possibilities,
+           const std::vector<PositionalClue> &clues);
+  void solve(ComboList &combo_list);
+  bool solve(const ComboVisitor &visitor);
+  SolverStats get_stats() const;
+  void set_control(SearchControl *control) { sat.set_control(control); }
+
+private:
+
+  int NUM_VALUES;
+  int NUM_PROPERTIES;
+
+  SatSolver sat;
+  int true_var;
+
+  // Variable of value v of property p > 0 being in house h, at
+  // ((p - 1)*NUM_VALUES + v)*NUM_VALUES + h
+  std::vector<int> placed;
+
+  // Variables of two items sharing a house, made as the clues need them
+  std::map<std::pair<int, int>, int> together;
+
+  // Index of each factoid in the possibilities
+  std::map<Factoid, int> rows;
+
+  // Combos found so far
+  SolverStats stats;
+
+  int constant(bool value) const {
+    return SatSolver::literal(true_var, !value);
+  }
+  int at(int property, int value, int house) const;
+  int same(int property1, int value1, int property2, int value2);
+};
+
+#endif
@@ -0,0 +1,456 @@
+#include <algorithm>
+#include "sat_solver.h"
+
+namespace {
+
+// Conflicts before the first restart, later ones are multiples of it
+const int RESTART_UNIT = 100;
+
+const double ACTIVITY_DECAY = 0.95;
+
+// Element i of the Luby sequence 1 1 2 1 1 2 4 1 1 2 ...
+long luby(long i) {
+  long size = 1;
+  int seq = 0;
+  while (size < i + 1) {
+    ++seq;
+    size = 2*size + 1;
+  }
+  long x = i;
+  while (size - 1 != x) {
+    size = (size - 1) >> 1;
+    --seq;
+    x = x % size;
+  }
+  return 1L << seq;
+}
+
+}
+
+/*!
+  \brief Constructs a solver without variables or clauses
+*/
+SatSolver::SatSolver()
+  : queue_head(0), unsatisfiable(false), activity_increment(1),
+    num_learnt(0), max_learnt(2000), control(nullptr) {
+}
+
+/*!
+  \brief Adds a variable
+
+  \return The number of the variable
+*/
+int SatSolver::new_var() {
+  const int var = activity.size();
+  watches.resize(2*(var + 1));
+  assigns.push_back(0);
+  level.push_back(0);
+  reason.push_back(-1);
+  phase.push_back(false);
+  seen.push_back(false);
+  model.push_back(false);
+  activity.push_back(0);
+  heap_index.push_back(-1);
+  heap_insert(var);
+  return var;
+}
+
+/*!
+  \brief Adds a clause, the disjunction of some literals
+
+  \return false if the clauses can no longer be satisfied
+*/
+bool SatSolver::add_clause(std::vector<int> literals) {
+  backtrack(0);
+  if (unsatisfiable) {
+    return false;
+  }
+
+  std::sort(literals.begin(), literals.end());
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < literals.size(); ++i) {
+    const int lit = literals[i];
+    if (value(lit) == 1 || (kept > 0 && literals[kept - 1] == (lit ^ 1))) {
+      return true;
+    }
+    if (value(lit) == 0 && (kept == 0 || literals[kept - 1] != lit)) {
+      literals[kept++] = lit;
+    }
+  }
+  literals.resize(kept);
+
+  if (literals.empty()) {
+    unsatisfiable = true;
+  }
+  else if (literals.size() == 1) {
+    enqueue(literals[0], -1);
+    unsatisfiable = (propagate() != -1);
+  }
+  else {
+    store(literals, false, 0);
+  }
+  return !unsatisfiable;
+}
+
+/*!
+  \brief Looks for an assignment that satisfies all clauses
+
+  \return true if one was found, model_value() then gives it, false if
+          there is none or the SearchControl stopped the search
+*/
+bool SatSolver::solve() {
+  if (unsatisfiable) {
+    return false;
+  }
+  std::vector<int> learnt;
+  for (long restart = 0; ; ++restart) {
+    const long budget = RESTART_UNIT*luby(restart);
+    CSP_STATS_ADD(stats, restarts, restart > 0);
+
+    for (long conflicts = 0; ; ) {
+      const int conflict = propagate();
+      if (conflict != -1) {
+        CSP_STATS_ADD(stats, conflicts, 1);
+        ++conflicts;
+        if (decision_level() == 0) {
+          unsatisfiable = true;
+          return false;
+        }
+        int back_level;
+        analyze(conflict, learnt, back_level);
+        backtrack(back_level);
+        if (learnt.size() == 1) {
+          enqueue(learnt[0], -1);
+        }
+        else {
+          // Literal Block Distance, the number of decision levels involved
+          std::vector<int> levels;
+          for (int lit : learnt) {
+            levels.push_back(level[lit >> 1]);
+          }
+          std::sort(levels.begin(), levels.end());
+          const int lbd = std::unique(levels.begin(), levels.end()) -
+            levels.begin();
+          enqueue(learnt[0], store(learnt, true, lbd));
+          ++num_learnt;
+          CSP_STATS_ADD(stats, learnt_clauses, 1);
+        }
+        activity_increment /= ACTIVITY_DECAY;
+        continue;
+      }
+
+      if (conflicts >= budget) {
+        backtrack(0);
+        break;
+      }
+      if (num_learnt >= max_learnt) {
+        reduce_learnt();
+      }
+      const int next = pick_branch();
+      if (next == -1) {
+        for (int var = 0; var < num_vars(); ++var) {
+          model[var] = (assigns[var] > 0);
+        }
+        backtrack(0);
+        return true;
+      }
+      if (control && !control->charge()) {
+        backtrack(0);
+        return false;
+      }
+      CSP_STATS_ADD(stats, nodes, 1);
+      trail_limits.push_back(trail.size());
+      enqueue(next, -1);
+    }
+  }
+}
+
+// Private methods ----------------------------------------------
+
+int SatSolver::store(const std::vector<int> &literals, bool learnt, int lbd) {
+  int c;
+  if (free_clauses.empty()) {
+    c = clauses.size();
+    clauses.push_back(Clause());
+  }
+  else {
+    c = free_clauses.back();
+    free_clauses.pop_back();
+  }
+  Clause &clause = clauses[c];
+  clause.literals = literals;
+  clause.learnt = learnt;
+  clause.deleted = false;
+  clause.lbd = lbd;
+  watches[literals[0]].push_back(c);
+  watches[literals[1]].push_back(c);
+  return c;
+}
+
+void SatSolver::enqueue(int lit, int from) {
+  const int var = lit >> 1;
+  assigns[var] = (lit & 1) ? -1 : 1;
+  level[var] = decision_level();
+  reason[var] = from;
+  trail.push_back(lit);
+}
+
+/*!
+  \brief Assigns the literals that the assignments on the trail imply
+
+  \return The clause that became false, or -1
+*/
+int SatSolver::propagate() {
+  while (queue_head < trail.size()) {
+    const int false_lit = trail[queue_head++] ^ 1;
+    std::vector<int> &watching = watches[false_lit];
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < watching.size()) {
+      const int c = watching[i++];
+      std::vector<int> &literals = clauses[c].literals;
+      if (literals[0] == false_lit) {
+        std::swap(literals[0], literals[1]);
+      }
+      if (value(literals[0]) == 1) {
+        watching[j++] = c;
+        continue;
+      }
+
+      // Watch another literal that isn't false
+      bool moved = false;
+      for (std::size_t k = 2; k < literals.size(); ++k) {
+        if (value(literals[k]) != -1) {
+          std::swap(literals[1], literals[k]);
+          watches[literals[1]].push_back(c);
+          moved = true;
+          break;
+        }
+      }
+      if (moved) {
+        continue;
+      }
+
+      watching[j++] = c;
+      if (value(literals[0]) == -1) {
+        while (i < watching.size()) {
+          watching[j++] = watching[i++];
+        }
+        watching.resize(j);
+        queue_head = trail.size();
+        return c;
+      }
+      enqueue(literals[0], c);
+    }
+    watching.resize(j);
+  }
+  return -1;
+}
+
+/*!
+  \brief Learns a clause from a conflict
+
+  The clause has the negation of the first unique implication point and the
+  assignments of earlier levels that led to the conflict.
+
+  \param[in] conflict The clause that became false
+  \param[out] learnt The clause, with the literal to assert first
+  \param[out] back_level The level at which the clause asserts it
+*/
+void SatSolver::analyze(int conflict, std::vector<int> &learnt,
+                        int &back_level) {
+  learnt.assign(1, -1);
+  int pending = 0;
+  int lit = -1;
+  std::size_t index = trail.size();
+  int c = conflict;
+  do {
+    const std::vector<int> &literals = clauses[c].literals;
+    for (std::size_t k = (lit == -1) ? 0 : 1; k < literals.size(); ++k) {
+      const int q = literals[k];
+      const int var = q >> 1;
+      if (!seen[var] && level[var] > 0) {
+        seen[var] = true;
+        bump(var);
+        if (level[var] >= decision_level()) {
+          ++pending;
+        }
+        else {
+          learnt.push_back(q);
+        }
+      }
+    }
+    while (!seen[trail[--index] >> 1]) {
+    }
+    lit = trail[index];
+    c = reason[lit >> 1];
+    seen[lit >> 1] = false;
+    --pending;
+  } while (pending > 0);
+  learnt[0] = lit ^ 1;
+
+  // Drop the literals that the others imply through their reasons
+  const std::vector<int> marked(learnt.begin() + 1, learnt.end());
+  std::size_t kept = 1;
+  for (std::size_t k = 1; k < learnt.size(); ++k) {
+    if (!redundant(learnt[k])) {
+      learnt[kept++] = learnt[k];
+    }
+  }
+  learnt.resize(kept);
+  for (int q : marked) {
+    seen[q >> 1] = false;
+  }
+
+  back_level = 0;
+  for (std::size_t k = 1; k < learnt.size(); ++k) {
+    if (level[learnt[k] >> 1] > back_level) {
+      back_level = level[learnt[k] >> 1];
+      std::swap(learnt[1], learnt[k]);
+    }
+  }
+}
+
+bool SatSolver::redundant(int lit) const {
+  const int c = reason[lit >> 1];
+  if (c == -1) {
+    return false;
+  }
+  const std::vector<int> &literals = clauses[c].literals;
+  for (std::size_t k = 1; k < literals.size(); ++k) {
+    const int var = literals[k] >> 1;
+    if (!seen[var] && level[var] > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SatSolver::backtrack(int to_level) {
+  if (decision_level() <= to_level) {
+    return;
+  }
+  const std::size_t limit = trail_limits[to_level];
+  for (std::size_t i = trail.size(); i-- > limit; ) {
+    const int var = trail[i] >> 1;
+    phase[var] = (assigns[var] > 0);
+    assigns[var] = 0;
+    reason[var] = -1;
+    if (heap_index[var] == -1) {
+      heap_insert(var);
+    }
+  }
+  trail.resize(limit);
+  trail_limits.resize(to_level);
+  queue_head = trail.size();
+}
+
+int SatSolver::pick_branch() {
+  while (!heap.empty()) {
+    const int var = heap_pop();
+    if (assigns[var] == 0) {
+      return literal(var, !phase[var]);
+    }
+  }
+  return -1;
+}
+
+void SatSolver::bump(int var) {
+  activity[var] += activity_increment;
+  if (activity[var] > 1e100) {
+    for (double &a : activity) {
+      a *= 1e-100;
+    }
+    activity_increment *= 1e-100;
+  }
+  if (heap_index[var] != -1) {
+    heap_up(heap_index[var]);
+  }
+}
+
+/*!
+  \brief Drops half of the learnt clauses, those with the most levels
+*/
+void SatSolver::reduce_learnt() {
+  std::vector<int> candidates;
+  for (int c = 0; c < (int)clauses.size(); ++c) {
+    if (clauses[c].learnt && !clauses[c].deleted && clauses[c].lbd > 2 &&
+        !locked(c)) {
+      candidates.push_back(c);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), [this](int a, int b) {
+      return clauses[a].lbd > clauses[b].lbd;
+    });
+  candidates.resize(candidates.size()/2);
+  for (int c : candidates) {
+    clauses[c].deleted = true;
+    clauses[c].literals.clear();
+    free_clauses.push_back(c);
+    --num_learnt;
+  }
+  for (std::vector<int> &watching : watches) {
+    watching.erase(std::remove_if(watching.begin(), watching.end(),
+                                  [this](int c) {
+                                    return clauses[c].deleted;
+                                  }),
+                   watching.end());
+  }
+  max_learnt += max_learnt/10;
+}
+
+bool SatSolver::locked(int c) const {
+  const int lit = clauses[c].literals[0];
+  return value(lit) == 1 && reason[lit >> 1] == c;
+}
+
+void SatSolver::heap_insert(int var) {
+  heap_index[var] = heap.size();
+  heap.push_back(var);
+  heap_up(heap.size() - 1);
+}
+
+int SatSolver::heap_pop() {
+  const int top = heap[0];
+  heap_index[top] = -1;
+  heap[0] = heap.back();
+  heap.pop_back();
+  if (!heap.empty()) {
+    heap_index[heap[0]] = 0;
+    heap_down(0);
+  }
+  return top;
+}
+
+void SatSolver::heap_up(int i) {
+  const int var = heap[i];
+  while (i > 0 && activity[heap[(i - 1)/2]] < activity[var]) {
+    heap[i] = heap[(i - 1)/2];
+    heap_index[heap[i]] = i;
+    i = (i - 1)/2;
+  }
+  heap[i] = var;
+  heap_index[var] = i;
+}
+
+void SatSolver::heap_down(int i) {
+  const int var = heap[i];
+  const int size = heap.size();
+  for (;;) {
+    int child = 2*i + 1;
+    if (child >= size) {
+      break;
+    }
+    if (child + 1 < size && activity[heap[child + 1]] > activity[heap[child]]) {
+      ++child;
+    }
+    if (activity[heap[child]] <= activity[var]) {
+      break;
+    }
+    heap[i] = heap[child];
+    heap_index[heap[i]] = i;
+    i = child;
+  }
+  heap[i] = var;
+  heap_index[var] = i;
+}
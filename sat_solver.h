@@ -0,0 +1,104 @@
+#ifndef SAT_SOLVER_H
+#define SAT_SOLVER_H
+
+#include <cstdint>
+#include <vector>
+#include "search_control.h"
+#include "solver_stats.h"
+
+/*!
+  \brief A small CDCL SAT solver
+
+  Clauses are watched by two literals, a conflict is analysed back to its
+  first unique implication point and the learnt clause is kept, the next
+  variable is the most active one of recent conflicts and restarts follow
+  the Luby sequence. Learnt clauses with many decision levels are dropped
+  when there are too many of them.
+
+  Variables are numbered from 0 and a literal is 2*var for the variable and
+  2*var + 1 for its negation. Clauses can be added between calls to
+  solve(), e.g. to block a solution that was already found, and the learnt
+  clauses stay valid.
+*/
+class SatSolver {
+
+public:
+
+  SatSolver();
+
+  static int literal(int var, bool negated = false) {
+    return 2*var + negated;
+  }
+
+  int new_var();
+  int num_vars() const { return activity.size(); }
+  bool add_clause(std::vector<int> literals);
+  bool solve();
+  bool model_value(int var) const { return model[var]; }
+  const SolverStats &get_stats() const { return stats; }
+  void set_control(SearchControl *control) { this->control = control; }
+
+private:
+
+  struct Clause {
+    std::vector<int> literals;
+    bool learnt;
+    bool deleted;
+    int lbd;
+  };
+
+  std::vector<Clause> clauses;
+  std::vector<std::vector<int>> watches;  // Clauses watching each literal
+  std::vector<int> free_clauses;
+
+  // Per variable: 1 true, -1 false, 0 unassigned
+  std::vector<int8_t> assigns;
+  std::vector<int> level;
+  std::vector<int> reason;
+  std::vector<bool> phase;
+  std::vector<bool> seen;
+  std::vector<bool> model;
+
+  std::vector<int> trail;
+  std::vector<int> trail_limits;
+  std::size_t queue_head;
+  bool unsatisfiable;
+
+  // Branching order, a max-heap of variables on their activity
+  std::vector<double> activity;
+  double activity_increment;
+  std::vector<int> heap;
+  std::vector<int> heap_index;
+
+  int num_learnt;
+  int max_learnt;
+
+  SolverStats stats;
+
+  // Budget of the search, each decision is a node, or nullptr
+  SearchControl *control;
+
+  int value(int lit) const {
+    const int8_t v = assigns[lit >> 1];
+    return (lit & 1) ? -v : v;
+  }
+  int decision_level() const { return trail_limits.size(); }
+
+  int store(const std::vector<int> &literals, bool learnt, int lbd);
+  void enqueue(int lit, int from);
+  int propagate();
+  void analyze(int conflict, std::vector<int> &learnt, int &back_level);
+  bool redundant(int lit) const;
+  void backtrack(int to_level);
+  int pick_branch();
+  void bump(int var);
+  void reduce_learnt();
+  bool locked(int c) const;
+
+  void heap_insert(int var);
+  int heap_pop();
+  void heap_up(int i);
+  void heap_down(int i);
+};
+
+#endif
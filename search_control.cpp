@@ -0,0 +1,99 @@
+#include "search_control.h"
+
+SearchControl::SearchControl()
+  : state(SEARCH_RUNNING), node_count(0), poll_count(0), combo_count(0),
+    explored(0), node_limit(0), has_deadline(false) {
+}
+
+/*!
+  \brief Stops the search this many seconds from now, 0 for no limit
+*/
+void SearchControl::set_time_limit(double seconds) {
+  has_deadline = (seconds > 0);
+  deadline = std::chrono::steady_clock::now() +
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(seconds));
+}
+
+/*!
+  \brief Stops the search after this many nodes, 0 for no limit
+*/
+void SearchControl::set_node_limit(uint64_t nodes) {
+  node_limit = nodes;
+}
+
+/*!
+  \brief Asks the search to stop, from any thread
+*/
+void SearchControl::cancel() {
+  stop(SEARCH_CANCELLED);
+}
+
+/*!
+  \brief Counts nodes of the search against the limits
+
+  \return false if the search must stop
+*/
+bool SearchControl::charge(uint64_t nodes) {
+  const uint64_t total =
+    node_count.fetch_add(nodes, std::memory_order_relaxed) + nodes;
+  if (node_limit && total > node_limit) {
+    stop(SEARCH_OUT_OF_NODES);
+    return false;
+  }
+  return poll();
+}
+
+/*!
+  \brief Checks for cancellation and, now and then, the time limit, e.g.
+         between steps that aren't nodes of a search
+
+  \return false if the search must stop
+*/
+bool SearchControl::poll() {
+  if (state.load(std::memory_order_relaxed) != SEARCH_RUNNING) {
+    return false;
+  }
+  const uint64_t polls = poll_count.fetch_add(1, std::memory_order_relaxed);
+  if (has_deadline && polls % CLOCK_PERIOD == 0 &&
+      std::chrono::steady_clock::now() >= deadline) {
+    stop(SEARCH_OUT_OF_TIME);
+    return false;
+  }
+  return true;
+}
+
+/*!
+  \brief Reports how much of the search tree was explored, from 0 to 1
+*/
+void SearchControl::set_fraction(double fraction) {
+  explored.store(fraction, std::memory_order_relaxed);
+}
+
+/*!
+  \brief Marks a search that ran to the end as finished
+*/
+void SearchControl::finish() {
+  if (stop(SEARCH_FINISHED)) {
+    explored.store(1);
+  }
+}
+
+/*!
+  \brief Marks a search that ended with an exception as failed
+*/
+void SearchControl::fail() {
+  stop(SEARCH_FAILED);
+}
+
+// Private methods ----------------------------------------------
+
+/*!
+  \brief Moves from running to status, unless it stopped already
+
+  \return false if it had stopped already
+*/
+bool SearchControl::stop(SearchStatus status) {
+  int running = SEARCH_RUNNING;
+  return state.compare_exchange_strong(running, status);
+}
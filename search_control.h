@@ -0,0 +1,70 @@
+#ifndef SEARCH_CONTROL_H
+#define SEARCH_CONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+typedef enum {
+  SEARCH_RUNNING = 0,
+  SEARCH_FINISHED,
+  SEARCH_CANCELLED,
+  SEARCH_OUT_OF_TIME,
+  SEARCH_OUT_OF_NODES,
+  SEARCH_FAILED} SearchStatus;
+
+/*!
+  \brief Limits of a search and how far it got, shared by the threads that
+         search and the ones that watch
+
+  The searches charge each node they expand and give up as soon as
+  charge() returns false, keeping what they found so far. That happens when
+  cancel() is called from any thread, the time limit passes or the node
+  limit is used up. A search that ends with an exception is marked with
+  fail(). The clock is read every 64 nodes, so stopping takes
+  at most that many nodes.
+
+  The fraction is a guess of how much of the search tree was explored,
+  from the branches done near the root. It is 1 once the search finished.
+*/
+class SearchControl {
+
+public:
+
+  SearchControl();
+
+  void set_time_limit(double seconds);
+  void set_node_limit(uint64_t nodes);
+  void cancel();
+
+  bool charge(uint64_t nodes = 1);
+  bool poll();
+  void add_combo() { combo_count.fetch_add(1, std::memory_order_relaxed); }
+  void set_fraction(double fraction);
+  void finish();
+  void fail();
+
+  bool stopped() const { return status() != SEARCH_RUNNING; }
+  SearchStatus status() const { return SearchStatus(state.load()); }
+  uint64_t nodes() const { return node_count.load(); }
+  uint64_t combos() const { return combo_count.load(); }
+  double fraction() const { return explored.load(); }
+
+private:
+
+  static const uint64_t CLOCK_PERIOD = 64;
+
+  std::atomic<int> state;
+  std::atomic<uint64_t> node_count;
+  std::atomic<uint64_t> poll_count;
+  std::atomic<uint64_t> combo_count;
+  std::atomic<double> explored;
+
+  uint64_t node_limit;
+  bool has_deadline;
+  std::chrono::steady_clock::time_point deadline;
+
+  bool stop(SearchStatus status);
+};
+
+#endif
@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "solver_snapshot.h"
+
+namespace {
+
+const char MAGIC[8] = {'Z', 'E', 'B', 'R', 'A', 'S', 'S', '1'};
+
+// Fields of a positional clue in the file
+const int CLUE_FIELDS = 7;
+
+std::size_t aligned(std::size_t bytes) {
+  return (bytes + 7) & ~std::size_t(7);
+}
+
+}
+
+struct SolverSnapshot::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t table_type;
+  int32_t num_values;
+  int32_t num_properties;
+  uint32_t has_possibilities;
+  uint32_t pad;
+  uint64_t num_words;
+  uint64_t num_clues;
+  uint64_t names_size;
+  uint64_t num_possibilities;
+  uint64_t file_size;
+};
+
+/*!
+  \brief Where each section starts, worked out from the sizes in the header
+
+  Sections: the words of the store, the item counter of each property, the
+  positional clues, the names as NUL-terminated strings by property and
+  value, and the possibilities with one byte per property.
+*/
+class SolverSnapshot::Layout {
+
+  public:
+    std::size_t words;
+    std::size_t counters;
+    std::size_t clues;
+    std::size_t names;
+    std::size_t possibilities;
+    std::size_t end;
+
+    explicit Layout(const Header &head) {
+      words = aligned(sizeof(Header));
+      counters = words + head.num_words*sizeof(uint64_t);
+      clues = counters + aligned(head.num_properties*sizeof(int32_t));
+      names = clues + head.num_clues*CLUE_FIELDS*sizeof(int32_t);
+      possibilities = names + aligned(head.names_size);
+      end = possibilities +
+        aligned(head.num_possibilities*head.num_properties);
+    }
+};
+
+/*!
+  \brief Writes the state of a solver
+
+  \param[out] out A binary stream
+  \param[in] solver A solver without open checkpoints
+  \param[in] possibilities Its possibilities, to save working them out
+                           again, or nullptr
+  \return false if a checkpoint is open or the stream failed
+*/
+bool SolverSnapshot::write(std::ostream &out, const CspSolver &solver,
+                           const PossibilityList *possibilities) {
+  if (!solver.checkpoints.empty()) {
+    return false;
+  }
+  const WordVector &words = solver.truth_table->state();
+
+  std::string names;
+  for (const std::vector<std::string> &property_names : solver.names) {
+    for (int value = 0; value < solver.NUM_FACTS; ++value) {
+      if (value < (int)property_names.size()) {
+        names += property_names[value];
+      }
+      names += '\0';
+    }
+  }
+
+  Header head;
+  std::memset(&head, 0, sizeof(head));
+  std::memcpy(head.magic, MAGIC, sizeof(MAGIC));
+  head.version = VERSION;
+  head.table_type = solver.truth_table->table_type();
+  head.num_values = solver.NUM_FACTS;
+  head.num_properties = solver.NUM_PROPERTIES;
+  head.has_possibilities = (possibilities != nullptr);
+  head.num_words = words.size();
+  head.num_clues = solver.positional_clues.size();
+  head.names_size = names.size();
+  head.num_possibilities = possibilities ? possibilities->size() : 0;
+  const Layout layout(head);
+  head.file_size = layout.end;
+
+  // Written so far, a stream that can't seek has no position to ask for
+  std::size_t offset = 0;
+  auto put = [&out, &offset](const void *data, std::size_t bytes) {
+    out.write(static_cast<const char *>(data), bytes);
+    offset += bytes;
+  };
+  auto pad_to = [&put, &offset](std::size_t section) {
+    const char zeros[8] = {};
+    put(zeros, section - offset);
+  };
+
+  put(&head, sizeof(head));
+  pad_to(layout.words);
+  put(words.data(), words.size()*sizeof(uint64_t));
+  for (int count : solver.item_counter) {
+    const int32_t field = count;
+    put(&field, sizeof(field));
+  }
+  pad_to(layout.clues);
+  for (const PositionalClue &clue : solver.positional_clues) {
+    const int32_t fields[CLUE_FIELDS] = {
+      clue.type1, clue.value1, clue.type2, clue.value2, clue.property,
+      clue.relation, clue.distance};
+    put(fields, sizeof(fields));
+  }
+  put(names.data(), names.size());
+  pad_to(layout.possibilities);
+  if (possibilities) {
+    put(possibilities->data(), possibilities->size()*solver.NUM_PROPERTIES);
+  }
+  pad_to(layout.end);
+  return bool(out);
+}
+
+/*!
+  \brief Maps a snapshot file
+
+  \param path A file written by write()
+*/
+SolverSnapshot::SolverSnapshot(const std::string &path)
+  : base(nullptr), mapped(0) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    message = "can't open " + path;
+    return;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (std::size_t)info.st_size < sizeof(Header)) {
+    message = path + " is not a solver snapshot";
+    close(fd);
+    return;
+  }
+  void *address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    message = "can't map " + path;
+    return;
+  }
+  base = static_cast<const char *>(address);
+  mapped = info.st_size;
+  if (!check()) {
+    message = path + ": " + message;
+    munmap(const_cast<char *>(base), mapped);
+    base = nullptr;
+    mapped = 0;
+    return;
+  }
+
+  if (has_possibilities()) {
+    const Layout layout(*header());
+    possibility_list = PossibilityList::view(
+      reinterpret_cast<const uint8_t *>(base + layout.possibilities),
+      header()->num_possibilities, header()->num_properties);
+  }
+}
+
+SolverSnapshot::~SolverSnapshot() {
+  if (base) {
+    munmap(const_cast<char *>(base), mapped);
+  }
+}
+
+int SolverSnapshot::num_values() const {
+  return base ? header()->num_values : 0;
+}
+
+int SolverSnapshot::num_properties() const {
+  return base ? header()->num_properties : 0;
+}
+
+TableType SolverSnapshot::table_type() const {
+  return base ? TableType(header()->table_type) : DENSE_TABLE;
+}
+
+bool SolverSnapshot::has_possibilities() const {
+  return base && header()->has_possibilities;
+}
+
+/*!
+  \brief Puts a solver in the state of the snapshot
+
+  The solver must have the same number of values and properties and the
+  same table type, and no open checkpoints. Its fact items, clues and
+  possibilities are replaced. A FixedCspSolver can restore a snapshot of a
+  dense table.
+
+  \return false if the solver doesn't match the snapshot
+*/
+bool SolverSnapshot::restore(CspSolver &solver) {
+  if (!base) {
+    return false;
+  }
+  const Header &head = *header();
+  const Layout layout(head);
+  if (solver.NUM_FACTS != head.num_values ||
+      solver.NUM_PROPERTIES != head.num_properties ||
+      solver.truth_table->table_type() != TableType(head.table_type)) {
+    message = "the solver has another shape or table type";
+    return false;
+  }
+  if (!solver.checkpoints.empty() ||
+      !solver.truth_table->set_state(
+        reinterpret_cast<const uint64_t *>(base + layout.words),
+        head.num_words)) {
+    message = "the solver has open checkpoints or another layout";
+    return false;
+  }
+
+  const int32_t *counters =
+    reinterpret_cast<const int32_t *>(base + layout.counters);
+  solver.item_counter.assign(counters, counters + head.num_properties);
+
+  const int32_t *fields =
+    reinterpret_cast<const int32_t *>(base + layout.clues);
+  solver.positional_clues.resize(head.num_clues);
+  for (PositionalClue &clue : solver.positional_clues) {
+    clue.type1 = fields[0];
+    clue.value1 = fields[1];
+    clue.type2 = fields[2];
+    clue.value2 = fields[3];
+    clue.property = fields[4];
+    clue.relation = Relation(fields[5]);
+    clue.distance = fields[6];
+    fields += CLUE_FIELDS;
+  }
+
+  const char *name = base + layout.names;
+  for (std::vector<std::string> &property_names : solver.names) {
+    property_names.resize(head.num_values);
+    for (std::string &value_name : property_names) {
+      value_name = name;
+      name += value_name.size() + 1;
+    }
+  }
+  return true;
+}
+
+// Private methods ----------------------------------------------
+
+/*!
+  \brief Checks that the header and the sections fit the file, and that
+         the counters, clues, names and possibilities are in range
+*/
+bool SolverSnapshot::check() {
+  const Header &head = *header();
+  if (std::memcmp(head.magic, MAGIC, sizeof(MAGIC)) != 0) {
+    message = "not a solver snapshot";
+    return false;
+  }
+  if (head.version != VERSION) {
+    message = "snapshot version " + std::to_string(head.version) +
+      ", expected " + std::to_string(VERSION);
+    return false;
+  }
+  // One byte per property in a factoid
+  if (head.num_values <= 0 || head.num_values > MAX_VALUES ||
+      head.num_properties <= 0 || head.num_properties > 256 ||
+      head.table_type > PAIRWISE_TABLE ||
+      head.num_words > mapped || head.num_clues > mapped ||
+      head.names_size > mapped || head.num_possibilities > mapped ||
+      head.file_size != mapped || Layout(head).end != mapped) {
+    message = "truncated or damaged snapshot";
+    return false;
+  }
+
+  const Layout layout(head);
+  const int32_t *counters =
+    reinterpret_cast<const int32_t *>(base + layout.counters);
+  for (int p = 0; p < head.num_properties; ++p) {
+    if (counters[p] < 0 || counters[p] > head.num_values) {
+      message = "bad item counter in snapshot";
+      return false;
+    }
+  }
+
+  const int32_t *fields =
+    reinterpret_cast<const int32_t *>(base + layout.clues);
+  for (std::size_t c = 0; c < head.num_clues; ++c, fields += CLUE_FIELDS) {
+    if (fields[0] < 0 || fields[0] >= head.num_properties ||
+        fields[1] < 0 || fields[1] >= head.num_values ||
+        fields[2] < 0 || fields[2] >= head.num_properties ||
+        fields[3] < 0 || fields[3] >= head.num_values ||
+        fields[4] < 0 || fields[4] >= head.num_properties ||
+        fields[5] < OFFSET || fields[5] > DISTANCE) {
+      message = "bad positional clue in snapshot";
+      return false;
+    }
+  }
+
+  // Every name ends inside its section
+  const std::size_t num_names =
+    (std::size_t)head.num_values*head.num_properties;
+  const char *names = base + layout.names;
+  if (std::count(names, names + head.names_size, '\0') != (long)num_names ||
+      (head.names_size && names[head.names_size - 1] != '\0')) {
+    message = "bad names in snapshot";
+    return false;
+  }
+
+  const uint8_t *values =
+    reinterpret_cast<const uint8_t *>(base + layout.possibilities);
+  const std::size_t num_bytes = head.num_possibilities*head.num_properties;
+  for (std::size_t i = 0; i < num_bytes; ++i) {
+    if (values[i] >= head.num_values) {
+      message = "bad possibility in snapshot";
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,68 @@
+#ifndef SOLVER_SNAPSHOT_H
+#define SOLVER_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "csp_solver.h"
+
+/*!
+  \brief The state of a CspSolver after its clues, saved to a binary file
+
+  A snapshot holds the words of the domain store, the positional clues, the
+  names of the items and, optionally, the possibilities worked out from
+  them. Restoring one into a solver of the same shape and table type gives
+  the solver it was written from, without replaying the clues.
+
+  The file is a header followed by the sections as raw arrays, each aligned
+  to 8 bytes, and is mapped read-only. The words are copied into the solver,
+  which changes them with further clues, but possibilities() reads its rows
+  straight from the mapping, so processes that open the same snapshot share
+  those pages. The list must not outlive the snapshot.
+
+  The file is in the byte order of the machine. A file of another version
+  is refused rather than converted.
+*/
+class SolverSnapshot {
+
+public:
+
+  static const uint32_t VERSION = 1;
+
+  static bool write(std::ostream &out, const CspSolver &solver,
+                    const PossibilityList *possibilities = nullptr);
+
+  explicit SolverSnapshot(const std::string &path);
+  ~SolverSnapshot();
+  SolverSnapshot(const SolverSnapshot &) = delete;
+  SolverSnapshot &operator=(const SolverSnapshot &) = delete;
+
+  bool is_open() const { return base != nullptr; }
+  const std::string &error() const { return message; }
+
+  int num_values() const;
+  int num_properties() const;
+  TableType table_type() const;
+  bool has_possibilities() const;
+  const PossibilityList &possibilities() const { return possibility_list; }
+
+  bool restore(CspSolver &solver);
+
+private:
+
+  struct Header;
+  class Layout;
+
+  std::string message;
+  const char *base;
+  std::size_t mapped;
+  PossibilityList possibility_list;
+
+  const Header *header() const {
+    return reinterpret_cast<const Header *>(base);
+  }
+  bool check();
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include <sstream>
+#include "solver_stats.h"
+
+/*!
+  \brief Constructs statistics where everything is zero
+*/
+SolverStats::SolverStats()
+  : clues(0), cells_cleared(0), clue_seconds(0),
+    propagate_passes(0), propagate_seconds(0),
+    cells_visited(0), possibilities(0), possibility_seconds(0),
+    nodes(0), combos(0), clashes(0), relation_prunes(0), combo_seconds(0),
+    conflicts(0), learnt_clauses(0), restarts(0),
+    peak_list_bytes(0) {
+}
+
+/*!
+  \brief Checks whether the library collects statistics at all
+*/
+bool SolverStats::enabled() const {
+#ifdef CSP_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+  \brief Adds the counters and timers of another set of statistics,
+         e.g. of another thread
+*/
+void SolverStats::add(const SolverStats &other) {
+  clues += other.clues;
+  cells_cleared += other.cells_cleared;
+  clue_seconds += other.clue_seconds;
+  propagate_passes += other.propagate_passes;
+  propagate_seconds += other.propagate_seconds;
+  cells_visited += other.cells_visited;
+  possibilities += other.possibilities;
+  possibility_seconds += other.possibility_seconds;
+  nodes += other.nodes;
+  combos += other.combos;
+  clashes += other.clashes;
+  relation_prunes += other.relation_prunes;
+  combo_seconds += other.combo_seconds;
+  conflicts += other.conflicts;
+  learnt_clauses += other.learnt_clauses;
+  restarts += other.restarts;
+  if (other.peak_list_bytes > peak_list_bytes) {
+    peak_list_bytes = other.peak_list_bytes;
+  }
+}
+
+/*!
+  \brief Writes the statistics as a JSON object with one member per phase
+*/
+std::string SolverStats::to_json() const {
+  std::ostringstream json;
+  json << "{\"enabled\": " << (enabled() ? "true" : "false")
+       << ", \"clues\": {\"calls\": " << clues
+       << ", \"cells_cleared\": " << cells_cleared
+       << ", \"seconds\": " << clue_seconds << "}"
+       << ", \"propagate\": {\"passes\": " << propagate_passes
+       << ", \"seconds\": " << propagate_seconds << "}"
+       << ", \"possibilities\": {\"cells_visited\": " << cells_visited
+       << ", \"factoids\": " << possibilities
+       << ", \"seconds\": " << possibility_seconds << "}"
+       << ", \"combos\": {\"nodes\": " << nodes
+       << ", \"combos\": " << combos
+       << ", \"clashes\": " << clashes
+       << ", \"relation_prunes\": " << relation_prunes
+       << ", \"seconds\": " << combo_seconds << "}"
+       << ", \"sat\": {\"conflicts\": " << conflicts
+       << ", \"learnt_clauses\": " << learnt_clauses
+       << ", \"restarts\": " << restarts << "}"
+       << ", \"peak_list_bytes\": " << peak_list_bytes << "}";
+  return json.str();
+}
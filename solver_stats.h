@@ -0,0 +1,88 @@
+#ifndef SOLVER_STATS_H
+#define SOLVER_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*!
+  \brief Counters and timers of the work done by a CspSolver
+
+  They are only collected when the library is built with CSP_STATS defined
+  (the ZEBRAS_STATS option of CMake). Otherwise the macros below expand to
+  nothing and all values stay zero.
+*/
+class SolverStats {
+
+public:
+
+  SolverStats();
+
+  // connect()/disconnect()
+  uint64_t clues;
+  uint64_t cells_cleared;
+  double clue_seconds;
+
+  // propagate()
+  uint64_t propagate_passes;
+  double propagate_seconds;
+
+  // get_possibilities()
+  uint64_t cells_visited;
+  uint64_t possibilities;
+  double possibility_seconds;
+
+  // get_unique_combos() and friends
+  uint64_t nodes;
+  uint64_t combos;
+  uint64_t clashes;          // factoids rejected for reusing a value
+  uint64_t relation_prunes;  // factoids rejected by a positional clue
+  double combo_seconds;
+
+  // The CDCL_SAT search engine, its decisions count as nodes
+  uint64_t conflicts;
+  uint64_t learnt_clauses;
+  uint64_t restarts;
+
+  // Largest possibility or combo list handed out, in bytes
+  std::size_t peak_list_bytes;
+
+  bool enabled() const;
+  void add(const SolverStats &other);
+  std::string to_json() const;
+};
+
+/*!
+  \brief Adds the time until it goes out of scope to a timer
+*/
+class StatsTimer {
+
+public:
+
+  explicit StatsTimer(double &seconds)
+    : seconds(seconds), start(std::chrono::steady_clock::now()) {}
+  ~StatsTimer() {
+    seconds += std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+private:
+
+  double &seconds;
+  std::chrono::steady_clock::time_point start;
+};
+
+#ifdef CSP_STATS
+#define CSP_STATS_ADD(stats, counter, n) ((stats).counter += (n))
+#define CSP_STATS_MAX(stats, counter, n) \
+  ((stats).counter = std::max<std::size_t>((stats).counter, (n)))
+#define CSP_STATS_TIME(stats, timer) StatsTimer stats_timer((stats).timer)
+#else
+#define CSP_STATS_ADD(stats, counter, n) ((void)0)
+#define CSP_STATS_MAX(stats, counter, n) ((void)0)
+#define CSP_STATS_TIME(stats, timer) ((void)0)
+#endif
+
+#endif
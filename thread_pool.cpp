@@ -0,0 +1,125 @@
+#include "thread_pool.h"
+
+/*!
+  \brief Starts the worker threads
+
+  \param num_threads Number of workers, at least one
+*/
+WorkStealingPool::WorkStealingPool(int num_threads)
+  : queued(0), pending(0), next_queue(0), stopping(false) {
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    queues.emplace_back(new Queue);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back(&WorkStealingPool::run, this, i);
+  }
+}
+
+/*!
+  \brief Finishes the queued tasks and joins the workers
+*/
+WorkStealingPool::~WorkStealingPool() {
+  drain();
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+/*!
+  \brief Queues a task, spreading tasks round robin over the workers
+*/
+void WorkStealingPool::submit(Task task) {
+  ++pending;
+  Queue &queue = *queues[next_queue++ % queues.size()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    ++queued;
+  }
+  wake.notify_one();
+}
+
+/*!
+  \brief Blocks until all submitted tasks have finished
+
+  Rethrows the first exception that a task threw since the last wait().
+*/
+void WorkStealingPool::wait() {
+  std::exception_ptr thrown;
+  {
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    done.wait(lock, [this] { return pending == 0; });
+    std::swap(thrown, failure);
+  }
+  if (thrown) {
+    std::rethrow_exception(thrown);
+  }
+}
+
+// Private methods ----------------------------------------------
+
+void WorkStealingPool::drain() {
+  std::unique_lock<std::mutex> lock(wake_mutex);
+  done.wait(lock, [this] { return pending == 0; });
+}
+
+void WorkStealingPool::run(int worker) {
+  while (true) {
+    Task task;
+    if (pop(worker, task)) {
+      try {
+        task(worker);
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        if (!failure) {
+          failure = std::current_exception();
+        }
+      }
+      if (--pending == 0) {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        done.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    wake.wait(lock, [this] { return stopping || queued > 0; });
+    if (stopping && queued == 0) {
+      return;
+    }
+  }
+}
+
+bool WorkStealingPool::pop(int worker, Task &task) {
+  const int num_queues = queues.size();
+  for (int i = 0; i < num_queues; ++i) {
+    Queue &queue = *queues[(worker + i) % num_queues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+    // Own work from the back, stolen work from the front
+    if (i == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+    else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    --queued;
+    return true;
+  }
+  return false;
+}
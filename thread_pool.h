@@ -0,0 +1,62 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+  \brief A pool of threads that steal work from each other
+
+  Each worker has its own deque. It takes tasks from the back of its own
+  deque and, when that runs empty, steals from the front of the others.
+  Tasks are told which worker runs them, so they can keep per-thread state.
+  If a task throws, the other tasks still run and wait() rethrows the first
+  exception.
+*/
+class WorkStealingPool {
+
+public:
+
+  typedef std::function<void(int worker)> Task;
+
+  explicit WorkStealingPool(int num_threads);
+  ~WorkStealingPool();
+
+  int size() const { return threads.size(); }
+  void submit(Task task);
+  void wait();
+
+private:
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> threads;
+
+  std::mutex wake_mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  std::atomic<int> queued;
+  std::atomic<int> pending;
+  std::atomic<unsigned> next_queue;
+  bool stopping;
+
+  // The first exception thrown by a task since the last wait()
+  std::exception_ptr failure;
+
+  void run(int worker);
+  void drain();
+  bool pop(int worker, Task &task);
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef TRAIL_H
+#define TRAIL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "word_vector.h"
+
+/*!
+  \brief Undo log of the words of a bitset
+
+  While a checkpoint is open, the old value of each word is saved before a
+  clue changes it. Rolling back restores the saved words in reverse order,
+  so it costs as much as the changes since the checkpoint, not the size of
+  the bitset.
+*/
+class Trail {
+
+public:
+
+  bool active() const { return !marks.empty(); }
+  std::size_t depth() const { return marks.size(); }
+
+  void save(std::size_t index, uint64_t word) {
+    if (active()) {
+      entries.push_back({index, word});
+    }
+  }
+
+  void push() { marks.push_back(entries.size()); }
+
+  bool pop(WordVector &words) {
+    return pop(words, [](std::size_t) {});
+  }
+
+  /*!
+    \brief Restores the words saved since the last checkpoint and drops it
+
+    \param[in,out] words The words of the bitset
+    \param[in] restored Called with the index of each restored word
+    \return false if there was no checkpoint
+  */
+  template <class Restored>
+  bool pop(WordVector &words, Restored restored) {
+    if (marks.empty()) {
+      return false;
+    }
+    for (std::size_t e = entries.size(); e-- > marks.back(); ) {
+      words[entries[e].index] = entries[e].word;
+      restored(entries[e].index);
+    }
+    entries.resize(marks.back());
+    marks.pop_back();
+    return true;
+  }
+
+private:
+
+  struct Entry {
+    std::size_t index;
+    uint64_t word;
+  };
+
+  std::vector<Entry> entries;
+  std::vector<std::size_t> marks;
+};
+
+#endif
@@ -0,0 +1,502 @@
+#include <algorithm>
+#include <numeric>
+#include "truth_table.h"
+#include "pairwise_table.h"
+
+namespace {
+
+const std::int64_t WORD_BITS = 64;
+
+// Words per chunk, those of 64 summary words
+const std::size_t CHUNK_WORDS = WORD_BITS*WORD_BITS;
+
+/*!
+  \brief Sizes a bitset for n bits and sets them all
+*/
+void set_ones(std::vector<uint64_t> &bits, std::size_t n) {
+  bits.assign((n + WORD_BITS - 1)/WORD_BITS, ~uint64_t(0));
+  if (n % WORD_BITS) {
+    bits.back() = (uint64_t(1) << (n % WORD_BITS)) - 1;
+  }
+}
+
+/*!
+  \brief Returns a word with bits [first, last) set, clipped to the word
+*/
+uint64_t range_mask(std::int64_t first, std::int64_t last) {
+  if (first < 0) {
+    first = 0;
+  }
+  if (last > WORD_BITS) {
+    last = WORD_BITS;
+  }
+  if (first >= last) {
+    return 0;
+  }
+  const uint64_t ones = (last - first == WORD_BITS) ? ~uint64_t(0) :
+    ((uint64_t(1) << (last - first)) - 1);
+  return ones << first;
+}
+
+}
+
+/*!
+  \brief Yields, word by word, the cells where a property has a given value
+
+  Short strides repeat a precomputed word pattern. Long strides give runs of
+  at least a word, so the mask is worked out from the offset in the period.
+*/
+class TruthTable::Plane {
+
+public:
+
+  Plane(const TruthTable &table, int property, int value, std::size_t word)
+    : repeat(nullptr), position(0), period(0), first(0), last(0) {
+    const std::size_t stride = table.stride[property];
+    if (stride < (std::size_t)WORD_BITS) {
+      repeat = &table.pattern[property*table.NUM_VALUES + value];
+      position = word % repeat->size();
+    }
+    else {
+      period = stride*table.NUM_VALUES;
+      first = value*stride;
+      last = first + stride;
+      position = (word*WORD_BITS) % period;
+    }
+  }
+
+  uint64_t next() {
+    uint64_t mask;
+    if (repeat) {
+      mask = (*repeat)[position];
+      if (++position == repeat->size()) {
+        position = 0;
+      }
+    }
+    else {
+      const std::int64_t offset = position;
+      mask = range_mask(first - offset, last - offset) |
+        range_mask(first + period - offset, last + period - offset);
+      position += WORD_BITS;
+      if (position >= (std::size_t)period) {
+        position -= period;
+      }
+    }
+    return mask;
+  }
+
+private:
+
+  const std::vector<uint64_t> *repeat;
+  std::size_t position;
+  std::int64_t period;
+  std::int64_t first;
+  std::int64_t last;
+};
+
+/*!
+  \brief Constructs a truth table where all cells are true
+
+  \param num_values Number of values that each property can take
+  \param num_properties Number of properties, i.e. dimensions of the table
+*/
+TruthTable::TruthTable(int num_values, int num_properties)
+  : TruthTable(num_values, num_properties, true) {
+}
+
+/*!
+  \brief Constructs a truth table, without its words unless filled is set
+
+  A table of more cells than a size_t can count gets none, see fits().
+*/
+TruthTable::TruthTable(int num_values, int num_properties, bool filled) {
+  NUM_VALUES = num_values;
+  NUM_PROPERTIES = num_properties;
+
+  stride.resize(NUM_PROPERTIES);
+  num_cells = 1;
+  for (int i = NUM_PROPERTIES - 1; i >= 0; --i) {
+    stride[i] = num_cells;
+    if (__builtin_mul_overflow(num_cells, (std::size_t)NUM_VALUES,
+                               &num_cells)) {
+      num_cells = 0;
+      break;
+    }
+  }
+  if (filled) {
+    fill();
+  }
+
+  // The pattern of a short stride repeats after lcm(period, 64) bits
+  pattern.resize(NUM_PROPERTIES*NUM_VALUES);
+  for (int property = 0; property < NUM_PROPERTIES; ++property) {
+    const std::size_t s = stride[property];
+    if (s >= (std::size_t)WORD_BITS) {
+      continue;
+    }
+    const std::size_t period = s*NUM_VALUES;
+    const std::size_t length = period/std::gcd(period, (std::size_t)WORD_BITS);
+    for (int value = 0; value < NUM_VALUES; ++value) {
+      std::vector<uint64_t> &repeat = pattern[property*NUM_VALUES + value];
+      repeat.resize(length, 0);
+      for (std::size_t cell = 0; cell < length*WORD_BITS; ++cell) {
+        if ((cell/s) % NUM_VALUES == (std::size_t)value) {
+          repeat[cell/WORD_BITS] |= uint64_t(1) << (cell % WORD_BITS);
+        }
+      }
+    }
+  }
+}
+
+/*!
+  \brief Checks whether the cells of a table of this shape can be counted,
+         if not it gets none and must not be used
+*/
+bool TruthTable::fits(int num_values, int num_properties) {
+  std::size_t cells = 1;
+  for (int i = 0; i < num_properties; ++i) {
+    if (__builtin_mul_overflow(cells, (std::size_t)num_values, &cells)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+  \brief Sizes the words and sets all cells to true
+*/
+void TruthTable::fill() {
+  words.resize((num_cells + WORD_BITS - 1)/WORD_BITS, ~uint64_t(0));
+  if (num_cells % WORD_BITS) {
+    words.back() = range_mask(0, num_cells % WORD_BITS);
+  }
+  set_ones(summary, words.size());
+  set_ones(chunks, (words.size() + CHUNK_WORDS - 1)/CHUNK_WORDS);
+}
+
+/*!
+  \brief Gets the cell index of a factoid
+*/
+std::size_t TruthTable::index(const Factoid &factoid) const {
+  std::size_t index = 0;
+  for (int i = 0; i < NUM_PROPERTIES; ++i) {
+    index += stride[i]*factoid[i];
+  }
+  return index;
+}
+
+/*!
+  \brief Checks whether a cell is still true
+*/
+bool TruthTable::test_cell(std::size_t index) const {
+  return (words[index/WORD_BITS] >> (index % WORD_BITS)) & 1;
+}
+
+/*!
+  \brief Checks whether a factoid is still possible
+*/
+bool TruthTable::test(const Factoid &factoid) const {
+  return test_cell(index(factoid));
+}
+
+/*!
+  \brief Visits the factoids that are still possible
+
+  \param[in] level Number of leading properties already fixed in factoid
+  \param[in,out] factoid Work space with one entry per property
+  \param[in] visitor Called with each factoid whose cell is true
+  \return false if the visitor or the control stopped the enumeration
+*/
+bool TruthTable::visit_possibilities(int level, Factoid &factoid,
+                                     const FactoidVisitor &visitor) const {
+  // The leading properties fix a run of cells
+  std::size_t first = 0;
+  for (int i = 0; i < level; ++i) {
+    first += stride[i]*factoid[i];
+  }
+  Cursor cursor(*this, first,
+                first + (level ? stride[level - 1] : num_cells));
+  while (cursor.next(factoid)) {
+    CSP_STATS_ADD(stats, cells_visited, 1);
+    if (!visitor(factoid)) {
+      return false;
+    }
+  }
+  return !(control && control->stopped());
+}
+
+/*!
+  \brief Finds the pairs of values that occur together in some true cell
+
+  \param[out] support One matrix per property pair
+*/
+void TruthTable::project(PairwiseTable &support) const {
+  support.clear();
+  Factoid factoid(NUM_PROPERTIES);
+  for (std::size_t w = 0; w < words.size(); ++w) {
+    if (w % CHUNK_WORDS == 0 && !live_chunk(w/CHUNK_WORDS)) {
+      w += CHUNK_WORDS - 1;
+      continue;
+    }
+    uint64_t bits = words[w];
+    while (bits) {
+      std::size_t cell = w*WORD_BITS + __builtin_ctzll(bits);
+      bits &= bits - 1;
+      for (int i = 0; i < NUM_PROPERTIES; ++i) {
+        factoid[i] = cell/stride[i];
+        cell %= stride[i];
+      }
+      for (int i = 0; i < NUM_PROPERTIES; ++i) {
+        for (int j = i + 1; j < NUM_PROPERTIES; ++j) {
+          support.allow(i, factoid[i], j, factoid[j]);
+        }
+      }
+    }
+  }
+}
+
+/*!
+  \brief Marks all cells where both properties have the given values as false
+
+  Only the runs where the property with the longest stride has its value are
+  visited, when these runs are at least a word long.
+*/
+void TruthTable::disconnect(int property1, int value1,
+                            int property2, int value2) {
+  int major = property1;
+  int major_value = value1;
+  if (stride[property2] > stride[property1]) {
+    major = property2;
+    major_value = value2;
+  }
+
+  const std::size_t run = stride[major];
+  const auto both = [](uint64_t mask1, uint64_t mask2) {
+    return mask1 & mask2;
+  };
+  if (run < (std::size_t)WORD_BITS) {
+    sweep(0, words.size(), property1, value1, property2, value2, both);
+    return;
+  }
+
+  for (std::size_t start = major_value*run; start < num_cells;
+       start += run*NUM_VALUES) {
+    sweep(start/WORD_BITS, (start + run - 1)/WORD_BITS + 1,
+          property1, value1, property2, value2, both);
+  }
+}
+
+/*!
+  \brief Marks all cells where exactly one of the properties has its value
+         as false
+*/
+void TruthTable::connect(int property1, int value1,
+                         int property2, int value2) {
+  sweep(0, words.size(), property1, value1, property2, value2,
+        [](uint64_t mask1, uint64_t mask2) { return mask1 ^ mask2; });
+}
+
+/*!
+  \brief Undoes the clues since the last checkpoint and drops it
+
+  \return false if there was no checkpoint
+*/
+bool TruthTable::rollback() {
+  return trail.pop(words, [this](std::size_t w) {
+      summary[w/WORD_BITS] |= uint64_t(1) << (w % WORD_BITS);
+      const std::size_t chunk = w/CHUNK_WORDS;
+      chunks[chunk/WORD_BITS] |= uint64_t(1) << (chunk % WORD_BITS);
+    });
+}
+
+/*!
+  \brief Replaces the cells and works out the summary bits again
+*/
+bool TruthTable::set_state(const uint64_t *state, std::size_t num_words) {
+  if (!DomainStore::set_state(state, num_words)) {
+    return false;
+  }
+  std::fill(summary.begin(), summary.end(), 0);
+  std::fill(chunks.begin(), chunks.end(), 0);
+  for (std::size_t w = 0; w < words.size(); ++w) {
+    if (words[w]) {
+      summary[w/WORD_BITS] |= uint64_t(1) << (w % WORD_BITS);
+      const std::size_t chunk = w/CHUNK_WORDS;
+      chunks[chunk/WORD_BITS] |= uint64_t(1) << (chunk % WORD_BITS);
+    }
+  }
+  return true;
+}
+
+/*!
+  \brief Clears cells of a word, and its summary and chunk bits when they
+         run empty
+*/
+void TruthTable::clear_word(std::size_t w, uint64_t cleared) {
+  if (!(words[w] & cleared)) {
+    return;
+  }
+  clear_bits(words, w, cleared);
+  if (words[w]) {
+    return;
+  }
+  const std::size_t s = w/WORD_BITS;
+  summary[s] &= ~(uint64_t(1) << (w % WORD_BITS));
+  if (summary[s]) {
+    return;
+  }
+  const std::size_t chunk = w/CHUNK_WORDS;
+  const std::size_t first = chunk*WORD_BITS;
+  const std::size_t last = std::min(summary.size(), first + WORD_BITS);
+  if (std::all_of(summary.begin() + first, summary.begin() + last,
+                  [](uint64_t bits) { return bits == 0; })) {
+    chunks[chunk/WORD_BITS] &= ~(uint64_t(1) << (chunk % WORD_BITS));
+  }
+}
+
+/*!
+  \brief Checks whether a chunk has any true cell
+*/
+bool TruthTable::live_chunk(std::size_t chunk) const {
+  return (chunks[chunk/WORD_BITS] >> (chunk % WORD_BITS)) & 1;
+}
+
+/*!
+  \brief Finds the first chunk from a given one that has a true cell
+
+  \return The index of the chunk, or one past the last if there is none
+*/
+std::size_t TruthTable::next_chunk(std::size_t chunk) const {
+  const std::size_t end = chunks.size()*WORD_BITS;
+  std::size_t c = chunk/WORD_BITS;
+  if (c >= chunks.size()) {
+    return end;
+  }
+  uint64_t bits = chunks[c] & (~uint64_t(0) << (chunk % WORD_BITS));
+  while (!bits) {
+    if (++c == chunks.size()) {
+      return end;
+    }
+    bits = chunks[c];
+  }
+  return c*WORD_BITS + __builtin_ctzll(bits);
+}
+
+/*!
+  \brief Clears the cells that combine() picks from the planes of two
+         values, over a range of words
+
+  The range is swept a chunk at a time, in order, so a table that lives in a
+  file is paged in as a stream. The chunks without a true cell are not
+  touched.
+*/
+template <class Combine>
+void TruthTable::sweep(std::size_t first_word, std::size_t end_word,
+                       int property1, int value1, int property2, int value2,
+                       Combine combine) {
+  std::size_t w = first_word;
+  while (w < end_word) {
+    const std::size_t chunk = w/CHUNK_WORDS;
+    const std::size_t chunk_end = std::min(end_word, (chunk + 1)*CHUNK_WORDS);
+    if (!live_chunk(chunk)) {
+      w = chunk_end;
+      continue;
+    }
+    Plane plane1(*this, property1, value1, w);
+    Plane plane2(*this, property2, value2, w);
+    for (; w < chunk_end; ++w) {
+      clear_word(w, combine(plane1.next(), plane2.next()));
+    }
+  }
+}
+
+/*!
+  \brief Starts before the first cell of a range
+
+  \param table The table to iterate over
+  \param first The first cell of the range
+  \param last One past the last cell of the range
+*/
+TruthTable::Cursor::Cursor(const TruthTable &table, std::size_t first,
+                           std::size_t last)
+  : table(table), position(first), last(last), cell(0),
+    digits(table.NUM_PROPERTIES, 0) {
+}
+
+/*!
+  \brief Moves to the next true cell
+
+  The control of the table is polled at each word the cursor moves to.
+
+  \param[out] factoid Gets the coordinates of the cell
+  \return false when there are no more true cells in the range, or the
+          control of the table says to stop
+*/
+bool TruthTable::Cursor::next(Factoid &factoid) {
+  if (position >= last) {
+    return false;
+  }
+  std::size_t w = position/WORD_BITS;
+  uint64_t bits = table.words[w] & (~uint64_t(0) << (position % WORD_BITS));
+  while (!bits) {
+    w = next_word(w + 1);
+    if (w*WORD_BITS >= last) {
+      position = last;
+      return false;
+    }
+    bits = table.words[w];
+  }
+  const std::size_t found = w*WORD_BITS + __builtin_ctzll(bits);
+  if (found >= last ||
+      (found/WORD_BITS != cell/WORD_BITS && table.interrupted())) {
+    position = last;
+    return false;
+  }
+
+  // Add the distance to the mixed-radix coordinates of the previous cell
+  std::size_t carry = found - cell;
+  for (int i = table.NUM_PROPERTIES - 1; carry && i >= 0; --i) {
+    const std::size_t digit = digits[i] + carry;
+    if (digit < (std::size_t)table.NUM_VALUES) {
+      digits[i] = digit;
+      carry = 0;
+    }
+    else {
+      digits[i] = digit % table.NUM_VALUES;
+      carry = digit/table.NUM_VALUES;
+    }
+  }
+  cell = found;
+  position = found + 1;
+  std::copy(digits.begin(), digits.end(), factoid.begin());
+  return true;
+}
+
+/*!
+  \brief Finds the first word from a given one that has a true cell
+
+  \return The index of the word, or the number of words if there is none
+*/
+std::size_t TruthTable::Cursor::next_word(std::size_t word) const {
+  const std::vector<uint64_t> &summary = table.summary;
+  std::size_t s = word/WORD_BITS;
+  if (s >= summary.size()) {
+    return table.words.size();
+  }
+  uint64_t bits = summary[s] & (~uint64_t(0) << (word % WORD_BITS));
+  while (!bits) {
+    if (++s == summary.size() || s*WORD_BITS*WORD_BITS >= last ||
+        table.interrupted()) {
+      return table.words.size();
+    }
+    // Jump over the chunks without a true cell
+    if (s % WORD_BITS == 0 && !table.live_chunk(s/WORD_BITS)) {
+      s = table.next_chunk(s/WORD_BITS)*WORD_BITS;
+      if (s >= summary.size() || s*WORD_BITS*WORD_BITS >= last) {
+        return table.words.size();
+      }
+    }
+    bits = summary[s];
+  }
+  return s*WORD_BITS + __builtin_ctzll(bits);
+}
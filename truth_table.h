@@ -0,0 +1,109 @@
+#ifndef TRUTH_TABLE_H
+#define TRUTH_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "domain_store.h"
+
+/*!
+  \brief Dense truth table stored as a bitset of 64-bit words
+
+  The cell of a factoid f has index sum(f[i]*stride[i]). Property 0 has the
+  largest stride, so the cells are laid out in the same lexicographic order
+  as visit_possibilities() visits them. Clues are applied as bulk
+  operations on whole words instead of one cell at a time.
+
+  A summary bit per word tells whether the word has any true cell, so the
+  possibilities are found by jumping from one true cell to the next. A
+  second bit per chunk of 4096 words does the same for the summary words,
+  and the clues sweep the table chunk by chunk, in order, passing over the
+  chunks that have no true cell left.
+*/
+class TruthTable : public DomainStore {
+
+public:
+
+  class Cursor;
+
+  TruthTable(int num_values, int num_properties);
+
+  static bool fits(int num_values, int num_properties);
+
+  std::size_t index(const Factoid &factoid) const;
+  bool test_cell(std::size_t index) const;
+  std::size_t size() const { return num_cells; }
+
+  void connect(int property1, int value1, int property2, int value2);
+  void disconnect(int property1, int value1, int property2, int value2);
+  bool test(const Factoid &factoid) const;
+  bool visit_possibilities(int level, Factoid &factoid,
+                           const FactoidVisitor &visitor) const;
+  void project(PairwiseTable &support) const;
+  TableType table_type() const { return DENSE_TABLE; }
+  bool rollback();
+  bool set_state(const uint64_t *state, std::size_t num_words);
+
+protected:
+
+  TruthTable(int num_values, int num_properties, bool filled);
+  void fill();
+  WordVector &bits() { return words; }
+  const WordVector &bits() const { return words; }
+  void clear_word(std::size_t w, uint64_t cleared);
+  bool live_chunk(std::size_t chunk) const;
+  std::size_t next_chunk(std::size_t chunk) const;
+  template <class Combine>
+  void sweep(std::size_t first_word, std::size_t end_word,
+             int property1, int value1, int property2, int value2,
+             Combine combine);
+
+  class Plane;
+
+  int NUM_VALUES;
+  int NUM_PROPERTIES;
+
+  std::size_t num_cells;
+  std::vector<std::size_t> stride;
+  WordVector words;
+
+  // Bit w is set if words[w] has any true cell
+  std::vector<uint64_t> summary;
+
+  // Bit c is set if any of words[4096*c, 4096*(c + 1)) has a true cell
+  std::vector<uint64_t> chunks;
+
+  // Repeating word masks for the properties whose stride is shorter than a
+  // word, one per (property, value).
+  std::vector<std::vector<uint64_t>> pattern;
+};
+
+/*!
+  \brief Lazily iterates over the true cells in a range of a TruthTable
+
+  Empty words are skipped with the summary bits and the coordinates of a
+  cell are worked out from those of the previous one, so the cost follows
+  the number of true cells rather than the size of the range.
+*/
+class TruthTable::Cursor {
+
+public:
+
+  Cursor(const TruthTable &table, std::size_t first, std::size_t last);
+
+  bool next(Factoid &factoid);
+
+private:
+
+  const TruthTable &table;
+  std::size_t position;
+  std::size_t last;
+
+  // The cell before position and its coordinates
+  std::size_t cell;
+  std::vector<int> digits;
+
+  std::size_t next_word(std::size_t word) const;
+};
+
+#endif
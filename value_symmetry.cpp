@@ -0,0 +1,173 @@
+#include <algorithm>
+#include "value_symmetry.h"
+
+/*!
+  \brief Finds the classes of interchangeable values
+
+  \param num_values Number of values that each property can take
+  \param num_properties Number of properties
+  \param possibilities The factoids that the combos are made of
+  \param clues The positional clues that the combos must satisfy
+*/
+ValueSymmetry::ValueSymmetry(int num_values, int num_properties,
+                             const PossibilityList &possibilities,
+                             const std::vector<PositionalClue> &clues)
+  : possibilities(possibilities) {
+  NUM_VALUES = num_values;
+  NUM_PROPERTIES = num_properties;
+
+  // Rows holding each value of each property, at property*N + value
+  std::vector<std::vector<int>> holding(NUM_PROPERTIES*NUM_VALUES);
+  for (int row = 0; row < (int)possibilities.size(); ++row) {
+    const FactoidView factoid = possibilities[row];
+    rows.insert({Factoid(factoid), row});
+    for (int property = 0; property < NUM_PROPERTIES; ++property) {
+      holding[property*NUM_VALUES + factoid[property]].push_back(row);
+    }
+  }
+
+  // Values that the positional clues tell apart
+  std::vector<bool> fixed(NUM_PROPERTIES*NUM_VALUES, false);
+  for (const PositionalClue &clue : clues) {
+    fixed[clue.type1*NUM_VALUES + clue.value1] = true;
+    fixed[clue.type2*NUM_VALUES + clue.value2] = true;
+    std::fill(fixed.begin() + clue.property*NUM_VALUES,
+              fixed.begin() + (clue.property + 1)*NUM_VALUES, true);
+  }
+
+  for (int property = 1; property < NUM_PROPERTIES; ++property) {
+    std::vector<ValueClass> found;
+    for (int value = 0; value < NUM_VALUES; ++value) {
+      if (fixed[property*NUM_VALUES + value]) {
+        continue;
+      }
+      // Swaps are transitive, so comparing with the first value will do
+      bool joined = false;
+      for (ValueClass &value_class : found) {
+        if (swappable(holding, property, value_class.values[0], value)) {
+          value_class.values.push_back(value);
+          joined = true;
+          break;
+        }
+      }
+      if (!joined) {
+        found.push_back({property, {value}});
+      }
+    }
+    for (const ValueClass &value_class : found) {
+      if (value_class.values.size() > 1) {
+        value_classes.push_back(value_class);
+      }
+    }
+  }
+}
+
+/*!
+  \brief Gets the number of combos that each canonical combo stands for
+*/
+uint64_t ValueSymmetry::orbit_size() const {
+  uint64_t size = 1;
+  for (const ValueClass &value_class : value_classes) {
+    for (std::size_t k = 2; k <= value_class.values.size(); ++k) {
+      size *= k;
+    }
+  }
+  return size;
+}
+
+/*!
+  \brief Adds the clues that only let canonical combos through
+
+  \param[in,out] clues The positional clues of the search
+*/
+void ValueSymmetry::break_symmetries(std::vector<PositionalClue> &clues) const {
+  for (const ValueClass &value_class : value_classes) {
+    for (std::size_t i = 1; i < value_class.values.size(); ++i) {
+      PositionalClue clue;
+      clue.type1 = value_class.property;
+      clue.value1 = value_class.values[i - 1];
+      clue.type2 = value_class.property;
+      clue.value2 = value_class.values[i];
+      clue.property = 0;
+      clue.relation = LEFT_OF;
+      clue.distance = 0;
+      clues.push_back(clue);
+    }
+  }
+}
+
+/*!
+  \brief Visits a canonical combo and all combos it stands for
+
+  \param[in] combo A combo found with the clues of break_symmetries()
+  \param[in] visitor Called with each sorted combo, returning false stops
+  \return false if the visitor stopped
+*/
+bool ValueSymmetry::expand(const FactCombo &combo,
+                           const ComboVisitor &visitor) const {
+  std::vector<Factoid> houses;
+  for (int row : combo) {
+    houses.push_back(Factoid(possibilities[row]));
+  }
+
+  // Where each value of each class is in the combo
+  std::vector<std::vector<int>> slots(value_classes.size());
+  for (std::size_t c = 0; c < value_classes.size(); ++c) {
+    const ValueClass &value_class = value_classes[c];
+    for (int value : value_class.values) {
+      for (std::size_t house = 0; house < houses.size(); ++house) {
+        if (houses[house][value_class.property] == value) {
+          slots[c].push_back(house);
+        }
+      }
+    }
+  }
+
+  FactCombo image(combo.size());
+  return permute(0, houses, slots, image, visitor);
+}
+
+// Private methods ----------------------------------------------
+
+bool ValueSymmetry::swappable(const std::vector<std::vector<int>> &holding,
+                              int property, int value1, int value2) const {
+  const std::vector<int> &rows1 = holding[property*NUM_VALUES + value1];
+  const std::vector<int> &rows2 = holding[property*NUM_VALUES + value2];
+  if (rows1.size() != rows2.size()) {
+    return false;
+  }
+  Factoid swapped(NUM_PROPERTIES);
+  for (int row : rows1) {
+    swapped = Factoid(possibilities[row]);
+    swapped[property] = value2;
+    if (!rows.count(swapped)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ValueSymmetry::permute(std::size_t c, std::vector<Factoid> &houses,
+                            const std::vector<std::vector<int>> &slots,
+                            FactCombo &image,
+                            const ComboVisitor &visitor) const {
+  if (c == value_classes.size()) {
+    for (std::size_t house = 0; house < houses.size(); ++house) {
+      image[house] = rows.at(houses[house]);
+    }
+    std::sort(image.begin(), image.end());
+    return visitor(image);
+  }
+
+  const ValueClass &value_class = value_classes[c];
+  std::vector<int> order = value_class.values;
+  do {
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      houses[slots[c][i]][value_class.property] = order[i];
+    }
+    if (!permute(c + 1, houses, slots, image, visitor)) {
+      return false;
+    }
+  } while (std::next_permutation(order.begin(), order.end()));
+  return true;
+}
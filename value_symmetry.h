@@ -0,0 +1,66 @@
+#ifndef VALUE_SYMMETRY_H
+#define VALUE_SYMMETRY_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "csp_types.h"
+#include "relations.h"
+
+/*!
+  \brief Values of one property that can be swapped in any combo
+*/
+class ValueClass {
+
+  public:
+    int property;
+    std::vector<int> values;
+};
+
+/*!
+  \brief Finds interchangeable values and the combos they stand for
+
+  Two values of a property are interchangeable when swapping them maps the
+  possibilities onto themselves and no positional clue mentions them or is
+  measured along their property, e.g. items that no clue mentions at all.
+  Any combo then gives another one with the two swapped, so a class of k
+  such values multiplies the combos by k!.
+
+  The searches only need the canonical combos, where the values of each
+  class lie in increasing order of property 0. break_symmetries() asks for
+  that with LEFT_OF clues, which every search engine already checks as it
+  goes, and expand() gives back the other combos of a canonical one.
+  Property 0 itself is never broken, it is what the others are ordered by.
+*/
+class ValueSymmetry {
+
+public:
+
+  ValueSymmetry(int num_values, int num_properties,
+                const PossibilityList &possibilities,
+                const std::vector<PositionalClue> &clues);
+
+  const std::vector<ValueClass> &classes() const { return value_classes; }
+  bool empty() const { return value_classes.empty(); }
+  uint64_t orbit_size() const;
+  void break_symmetries(std::vector<PositionalClue> &clues) const;
+  bool expand(const FactCombo &combo, const ComboVisitor &visitor) const;
+
+private:
+
+  int NUM_VALUES;
+  int NUM_PROPERTIES;
+  const PossibilityList &possibilities;
+
+  // Index of each factoid in the possibilities
+  std::map<Factoid, int> rows;
+  std::vector<ValueClass> value_classes;
+
+  bool swappable(const std::vector<std::vector<int>> &holding, int property,
+                 int value1, int value2) const;
+  bool permute(std::size_t c, std::vector<Factoid> &houses,
+               const std::vector<std::vector<int>> &slots,
+               FactCombo &image, const ComboVisitor &visitor) const;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "word_vector.h"
+
+/*!
+  \brief Creates and maps a scratch file
+
+  \param path A file that doesn't exist yet, on a disk with room for it
+  \param bytes The size of the region
+*/
+WordRegion::WordRegion(const std::string &path, std::size_t bytes)
+  : base(nullptr), mapped(0), lent(false) {
+  if (bytes == 0 || (off_t)bytes < 0) {
+    message = "can't map " + std::to_string(bytes) + " bytes";
+    return;
+  }
+  const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    message = "can't create " + path;
+    return;
+  }
+  void *address = MAP_FAILED;
+  if (ftruncate(fd, bytes) == 0) {
+    address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  unlink(path.c_str());
+  if (address == MAP_FAILED) {
+    message = "can't map " + path;
+    return;
+  }
+  // The clues sweep the words in order
+  madvise(address, bytes, MADV_SEQUENTIAL);
+  base = address;
+  mapped = bytes;
+}
+
+WordRegion::~WordRegion() {
+  if (base) {
+    munmap(base, mapped);
+  }
+}
+
+/*!
+  \brief Lends the region to a vector
+
+  \return The start of the region, nullptr if it is lent already or too
+          small
+*/
+void *WordRegion::lend(std::size_t bytes) {
+  if (!base || lent || bytes > mapped) {
+    return nullptr;
+  }
+  lent = true;
+  return base;
+}
+
+/*!
+  \brief Takes the region back from a vector
+
+  \return false if the address is not that of the region
+*/
+bool WordRegion::give_back(void *address) {
+  if (!lent || address != base) {
+    return false;
+  }
+  lent = false;
+  return true;
+}
@@ -0,0 +1,100 @@
+#ifndef WORD_VECTOR_H
+#define WORD_VECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+  \brief A scratch file mapped into memory, to hold words that may not fit
+         in RAM
+
+  The file is created, sized, mapped shared and removed right away, so the
+  kernel writes the pages out to it rather than to swap and it goes away
+  with the mapping, even if the process dies. The region is lent to one
+  vector at a time.
+*/
+class WordRegion {
+
+public:
+
+  WordRegion(const std::string &path, std::size_t bytes);
+  ~WordRegion();
+  WordRegion(const WordRegion &) = delete;
+  WordRegion &operator=(const WordRegion &) = delete;
+
+  bool is_open() const { return base != nullptr; }
+  const std::string &error() const { return message; }
+
+  void *lend(std::size_t bytes);
+  bool give_back(void *address);
+
+private:
+
+  std::string message;
+  void *base;
+  std::size_t mapped;
+  bool lent;
+};
+
+/*!
+  \brief Allocator of the words of a bitset, on the heap or in a WordRegion
+
+  A vector made with a region keeps its words there. Copies of it, and any
+  allocation the region can't take, go to the heap.
+*/
+template <class T>
+class WordAllocator {
+
+public:
+
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  WordAllocator() {}
+  explicit WordAllocator(std::shared_ptr<WordRegion> region)
+    : region(std::move(region)) {}
+  template <class U>
+  WordAllocator(const WordAllocator<U> &other) : region(other.region) {}
+
+  T *allocate(std::size_t n) {
+    if (region) {
+      if (void *address = region->lend(n*sizeof(T))) {
+        return static_cast<T *>(address);
+      }
+    }
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T *address, std::size_t n) {
+    if (!region || !region->give_back(address)) {
+      std::allocator<T>().deallocate(address, n);
+    }
+  }
+
+  WordAllocator select_on_container_copy_construction() const {
+    return WordAllocator();
+  }
+
+  template <class U>
+  bool operator==(const WordAllocator<U> &other) const {
+    return region == other.region;
+  }
+  template <class U>
+  bool operator!=(const WordAllocator<U> &other) const {
+    return region != other.region;
+  }
+
+private:
+
+  template <class U> friend class WordAllocator;
+
+  std::shared_ptr<WordRegion> region;
+};
+
+typedef std::vector<uint64_t, WordAllocator<uint64_t>> WordVector;
+
+#endif
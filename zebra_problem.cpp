@@ -12,18 +12,12 @@ typedef enum {
   SMOKE,
   NUM_CHARACTERISTICS} Characteristics;
 
-bool are_neighbours(FactItem* f1, FactItem* f2, CspSolver& solver,
-					const FactCombo& combo, const PossibilityList& possibilities) {
-	return std::abs(solver.get_property(f1, NUMBER, combo, possibilities) -
-	    			solver.get_property(f2, NUMBER, combo, possibilities)) == 1;
-}
-
 int main(int argc, char* argv[])
   {
 
-    CspSolver solver(NUM_HOUSES, NUM_CHARACTERISTICS);
+    FixedCspSolver<NUM_HOUSES, NUM_CHARACTERISTICS> solver;
 
-    // The internal order of the houses is used in the 'are_neighbours()'-function
+    // The internal order of the houses is used by the positional clues
     // So they must be defined in the right order.
     FactItem* one = solver.make_fact_item(NUMBER, "1");
     solver.make_fact_item(NUMBER, "2");
@@ -73,10 +67,12 @@ int main(int argc, char* argv[])
     FactItem* chesterfields = solver.make_fact_item(SMOKE, "Chesterfields");
     FactItem* fox = solver.make_fact_item(PET, "fox");
     solver.disconnect(chesterfields, fox);
+    solver.relate(chesterfields, fox, NUMBER, ADJACENT);
 
     // 12. Kools are smoked in the house next to the house where the horse is kept.
     FactItem* horse = solver.make_fact_item(PET, "horse");
     solver.disconnect(kools, horse);
+    solver.relate(kools, horse, NUMBER, ADJACENT);
 
     // 13. The Lucky Strike smoker drinks orange juice.
     FactItem* lucky_strike = solver.make_fact_item(SMOKE, "Lucky Strike");
@@ -91,6 +87,7 @@ int main(int argc, char* argv[])
     // 15. The Norwegian lives next to the blue house.
     FactItem* blue = solver.make_fact_item(COLOUR, "blue");
     solver.disconnect(Norwegian, blue);
+    solver.relate(Norwegian, blue, NUMBER, ADJACENT);
 
     // Now, who drinks water? Who owns the zebra?
     solver.make_fact_item(DRINK, "water");
@@ -102,8 +99,9 @@ int main(int argc, char* argv[])
     // brands of American cigarets [sic]. One other thing: in statement 6, right means
     // your right.
 
-    // Needed below
+    // 6. The green house is immediately to the right of the ivory house.
     FactItem* ivory = solver.make_fact_item(COLOUR, "ivory");
+    solver.relate(ivory, green, NUMBER, OFFSET, 1);
 
     std::cout << "Combinations that are possible according to the clues: "
         << std::endl;
@@ -118,6 +116,7 @@ int main(int argc, char* argv[])
         << std::endl;
 
     // Now we need to test so we don't put the same pet in two houses etc.
+    // The positional clues are checked while the combinations are built.
     ComboList combo_list;
     solver.get_unique_combos(combo_list, possibilities);
 
@@ -127,32 +126,18 @@ int main(int argc, char* argv[])
     std::cout << "After removing combinations that are impossible, " << std::endl
 	      << "there are " << combo_list.size() << " combinations "
       "remaining. " << std::endl; //
-
-    std::cout << "Now we need to check the final clues." << std::endl;
     std::cout << "--------------------------------------------------"
         << std::endl;
 
-    // Check which combo is consistent with relational clues
-
     for (auto combo : combo_list) {
-        // 6. The green house is immediately to the right of the ivory house.
-    	if ((solver.get_property(green, NUMBER, combo, possibilities) -
-    			solver.get_property(ivory, NUMBER, combo, possibilities) == 1) and
-    			// 11. The man who smokes Chesterfields lives in the house next to the man with the fox.
-    			are_neighbours(chesterfields, fox, solver, combo, possibilities) and
-			    // 12. Kools are smoked in the house next to the house where the horse is kept.
-				are_neighbours(kools, horse, solver, combo, possibilities) and
-			    // 15. The Norwegian lives next to the blue house.
-				are_neighbours(Norwegian, blue, solver, combo, possibilities)) {
-    		for (int row = 0; row < NUM_HOUSES; ++row ) {
-    			for (int property = 0; property < NUM_CHARACTERISTICS; ++property) {
-    				std::cout << solver.get_name(property, possibilities[combo[ row ]][property]) << " ";
-    			}
-    			std::cout << std::endl;
+    	for (int row = 0; row < NUM_HOUSES; ++row ) {
+    		for (int property = 0; property < NUM_CHARACTERISTICS; ++property) {
+    			std::cout << solver.get_name(property, possibilities[combo[ row ]][property]) << " ";
     		}
-    		std::cout << "--------------------------------------------------"
-    				<< std::endl;
+    		std::cout << std::endl;
     	}
+    	std::cout << "--------------------------------------------------"
+    			<< std::endl;
     }
 
     return 0;